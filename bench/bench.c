@@ -0,0 +1,776 @@
+#define _GNU_SOURCE
+
+#include "../utils/band.h"
+#include "../utils/band_file.h"
+#include "../utils/narrow.h"
+#include "../utils/power.h"
+#include "../utils/roofline.h"
+#include "../utils/series.h"
+#include "../utils/series_simd.h"
+#include "../utils/series_terms.h"
+#include "../utils/tridiag.h"
+#include "../utils/tridiag_simd.h"
+#include "../utils/utils.h"
+#include <getopt.h>
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Benchmark driver for the ex2 kernels.
+//
+// Usage: bench -k KERNEL[,KERNEL...] [-n SIZE] [-t THREADS] [-r REPS]
+//              [-w WARMUP] [-p POWER] [--cold] [--flush-mb MB] [-o CSV]
+//        bench --list
+//
+// Every kernel runs WARMUP untimed and REPS timed repetitions on the same
+// data. In warm mode the data stays wherever the previous repetition left it;
+// with --cold a buffer larger than the last level cache is streamed through
+// before every repetition. Reported rates use the median time and the
+// compulsory traffic of the kernel (every array read or written once, no
+// write-allocate), so GB/s is a lower bound of what the memory system moved.
+// The roofline share compares the ops rate with min(peak, intensity * triad
+// bandwidth), see roofline.h (run stream_probe first).
+// With PERF_COUNTERS set, one more repetition runs under hardware counters,
+// logged to the _perf.csv next to the results file. With MATRIX_FILE set, the
+// tridiagonal A is mapped from that band file (written on the first run) and
+// its order replaces SIZE, see band_file.h.
+
+#define DENSE_MAX_N 50000 // the naive kernels allocate n * n ints
+
+enum {
+  NEED_DENSE = 1 << 0,
+  NEED_TRIDIAG = 1 << 1,
+  NEED_SQUARE = 1 << 2,
+  NEED_PACKED = 1 << 3,
+  NEED_INT8 = 1 << 4,
+  NEED_BAND = 1 << 5,
+  NEED_SIMD = 1 << 6,
+  NEED_SERIES_SIMD = 1 << 7,
+  NEED_PING_PONG = 1 << 8,
+};
+
+typedef struct {
+  int n;
+  int k;
+  int num_threads;
+  int *vec;
+  int **dense;
+  TridiagMatrix *A;
+  PentaDiagMatrix *A2;
+  PackedTridiagMatrix *packed;
+  TridiagMatrix8 *A8;
+  int8_t *vec8;
+  BandMatrix *band;
+  BandFile *file; // mapping A comes from, NULL when A was generated
+  int *iter_x;    // ping-pong buffers of the iteration kernels, x copied into
+  int *iter_work; // iter_x before every repetition
+  double series;  // result of the series kernels
+} BenchData;
+
+typedef struct {
+  const char *name;
+  int needs;       // NEED_* flags, data built before the first repetition
+  int sequential;  // runs on one thread whatever -t says
+  double bytes;    // compulsory bytes per row and per product
+  double ops;      // operations per row and per product
+  int k_products;  // bytes and ops are paid k times (k separate products)
+  int k_ops;       // only the ops scale with k (temporal blocking)
+  void *(*run)(BenchData *d);
+  void (*release)(void *out);
+  // Per-row cost when it does not fit the fields above (may be NULL)
+  void (*cost)(const BenchData *d, double *bytes, double *ops);
+} BenchKernel;
+
+typedef struct {
+  double min;
+  double median;
+  double mean;
+  double stddev;
+  double gbs;       // at the median time
+  double gops;      // at the median time
+  double intensity; // ops per byte, -1 without memory traffic
+  double roofline;  // % of the roofline, -1 when no ceiling is known
+} BenchStats;
+
+// ################################################################################
+// Kernels
+// ################################################################################
+
+static void *run_matvec_naive_seq(BenchData *d) {
+  return sequential_matrix_vector_multiplication(d->dense, d->vec, d->n);
+}
+
+static void *run_matvec_naive_omp(BenchData *d) {
+  return omp_matrix_vector_multiplication(d->dense, d->vec, d->n,
+                                          d->num_threads);
+}
+
+static void *run_matvec_seq(BenchData *d) {
+  return sequential_matrix_opti_vector_multiplication(d->A, d->vec, d->n);
+}
+
+static void *run_matvec_omp(BenchData *d) {
+  return omp_matrix_opti_vector_multiplication(d->A, d->vec, d->n,
+                                               d->num_threads);
+}
+
+static void *run_matvec_simd_seq(BenchData *d) {
+  return simd_matrix_opti_vector_multiplication(d->A, d->vec, d->n);
+}
+
+static void *run_matvec_simd_omp(BenchData *d) {
+  return omp_simd_matrix_opti_vector_multiplication(d->A, d->vec, d->n,
+                                                    d->num_threads);
+}
+
+static void *run_matvec_packed_seq(BenchData *d) {
+  return sequential_packed_matrix_vector_multiplication(d->packed, d->vec,
+                                                        d->n);
+}
+
+static void *run_matvec_packed_omp(BenchData *d) {
+  return omp_packed_matrix_vector_multiplication(d->packed, d->vec, d->n,
+                                                 d->num_threads);
+}
+
+static void *run_matvec_int8_omp(BenchData *d) {
+  return omp_matrix8_vector_multiplication(d->A8, d->vec8, d->n,
+                                           d->num_threads);
+}
+
+// k separate products, each one streaming the matrix and the vector again
+static void *run_power_vector_seq(BenchData *d) {
+  int *power = d->vec;
+  for (int s = 0; s < d->k; s++) {
+    int *next = sequential_matrix_opti_vector_multiplication(d->A, power, d->n);
+    if (power != d->vec)
+      free(power);
+    power = next;
+  }
+  return power == d->vec ? NULL : power;
+}
+
+static void *run_power_vector_omp(BenchData *d) {
+  int *power = d->vec;
+  for (int s = 0; s < d->k; s++) {
+    int *next = omp_matrix_opti_vector_multiplication(d->A, power, d->n,
+                                                      d->num_threads);
+    if (power != d->vec)
+      free(power);
+    power = next;
+  }
+  return power == d->vec ? NULL : power;
+}
+
+// Only the iterations are timed: the ping-pong buffers are allocated once
+// and x is restored by bench_kernel, outside the timed region
+static void *run_power_vector_iterate(BenchData *d, int parallel) {
+  if (parallel)
+    omp_matrix_opti_vector_iterate(d->A, d->iter_x, d->iter_work, d->n, d->k,
+                                   d->num_threads);
+  else
+    sequential_matrix_opti_vector_iterate(d->A, d->iter_x, d->iter_work, d->n,
+                                          d->k);
+  return NULL;
+}
+
+static void *run_power_vector_iterate_seq(BenchData *d) {
+  return run_power_vector_iterate(d, 0);
+}
+
+static void *run_power_vector_iterate_omp(BenchData *d) {
+  return run_power_vector_iterate(d, 1);
+}
+
+static void *run_power_vector_tiled_seq(BenchData *d) {
+  return sequential_matrix_opti_power_vector_multiplication(d->A, d->vec, d->n,
+                                                            d->k);
+}
+
+static void *run_power_vector_tiled_omp(BenchData *d) {
+  return omp_matrix_opti_power_vector_multiplication(d->A, d->vec, d->n, d->k,
+                                                     d->num_threads);
+}
+
+static void *run_square_seq(BenchData *d) {
+  return compute_square_tridiagonal(d->A);
+}
+
+static void *run_square_omp(BenchData *d) {
+  return compute_square_tridiagonal_omp(d->A, d->num_threads);
+}
+
+static void *run_square_int8_omp(BenchData *d) {
+  return compute_square_tridiagonal8_omp(d->A8, d->num_threads);
+}
+
+static void *run_cube_seq(BenchData *d) {
+  return compute_cube_tridiagonal(d->A, d->A2);
+}
+
+static void *run_cube_omp(BenchData *d) {
+  return compute_cube_tridiagonal_omp(d->A, d->A2, d->num_threads);
+}
+
+static void *run_band_power_omp(BenchData *d) {
+  return band_power(d->band, d->k, d->num_threads);
+}
+
+static void release_vec(void *out) { free(out); }
+
+static void release_penta(void *out) { free_penta(out); }
+
+static void release_penta16(void *out) { free_penta16(out); }
+
+static void release_hepta(void *out) { free_hepta(out); }
+
+static void release_band(void *out) { free_band(out); }
+
+static void release_none(void *out) { (void)out; }
+
+static void *run_series_seq(BenchData *d) {
+  d->series = sequential_series_sum(d->n);
+  return NULL;
+}
+
+static void *run_series_omp(BenchData *d) {
+  d->series = omp_series_sum(d->n, d->num_threads);
+  return NULL;
+}
+
+static void *run_series_repro_omp(BenchData *d) {
+  d->series = repro_series_sum(d->n, d->num_threads);
+  return NULL;
+}
+
+// The same engine instantiated for three series
+#define SERIES_NAME ex1_engine
+#define SERIES_TERM(i) ex1_term((double)(i))
+#define SERIES_TERM_D(d, i) ex1_term(d)
+#include "../utils/series_engine.h"
+
+#define SERIES_NAME basel_engine
+#define SERIES_TERM(i) basel_term((double)(i))
+#define SERIES_TERM_D(d, i) basel_term(d)
+#include "../utils/series_engine.h"
+
+#define SERIES_NAME alt_harmonic_engine
+#define SERIES_TERM(i) alt_harmonic_term(i, (double)(i))
+#define SERIES_TERM_D(d, i) alt_harmonic_term(i, d)
+#include "../utils/series_engine.h"
+
+static void *run_engine_ex1_seq(BenchData *d) {
+  d->series = ex1_engine_simd(1, d->n);
+  return NULL;
+}
+
+static void *run_engine_ex1_omp(BenchData *d) {
+  d->series = ex1_engine_omp(1, d->n, d->num_threads);
+  return NULL;
+}
+
+static void *run_engine_basel_omp(BenchData *d) {
+  d->series = basel_engine_omp(1, d->n, d->num_threads);
+  return NULL;
+}
+
+static void *run_engine_alt_harmonic_omp(BenchData *d) {
+  d->series = alt_harmonic_engine_omp(1, d->n, d->num_threads);
+  return NULL;
+}
+
+static void *run_series_simd_seq(BenchData *d) {
+  d->series = simd_series_sum(d->n);
+  return NULL;
+}
+
+static void *run_series_simd_omp(BenchData *d) {
+  d->series = omp_simd_series_sum(d->n, d->num_threads);
+  return NULL;
+}
+
+static void band_cost(const BenchData *d, double *bytes, double *ops) {
+  band_power_cost(d->band, d->k, bytes, ops);
+}
+
+// Per-row costs are the ones declared next to each kernel
+static const BenchKernel kernels[] = {
+    {"matvec_naive_seq", NEED_DENSE, 1,
+     TRIDIAG_DENSE_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_naive_seq, release_vec, NULL},
+    {"matvec_naive_omp", NEED_DENSE, 0,
+     TRIDIAG_DENSE_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_naive_omp, release_vec, NULL},
+    {"matvec_seq", NEED_TRIDIAG, 1,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_seq, release_vec, NULL},
+    {"matvec_omp", NEED_TRIDIAG, 0,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_omp, release_vec, NULL},
+    {"matvec_simd_seq", NEED_TRIDIAG | NEED_SIMD, 1,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_simd_seq, release_vec, NULL},
+    {"matvec_simd_omp", NEED_TRIDIAG | NEED_SIMD, 0,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_simd_omp, release_vec, NULL},
+    {"matvec_packed_seq", NEED_PACKED, 1,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_packed_seq, release_vec, NULL},
+    {"matvec_packed_omp", NEED_PACKED, 0,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_packed_omp, release_vec, NULL},
+    {"matvec_int8_omp", NEED_INT8, 0,
+     TRIDIAG8_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 0,
+     run_matvec_int8_omp, release_vec, NULL},
+    {"power_vector_seq", NEED_TRIDIAG, 1,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 1, 0,
+     run_power_vector_seq, release_vec, NULL},
+    {"power_vector_omp", NEED_TRIDIAG, 0,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 1, 0,
+     run_power_vector_omp, release_vec, NULL},
+    {"power_vector_iterate_seq", NEED_TRIDIAG | NEED_PING_PONG, 1,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 1, 0,
+     run_power_vector_iterate_seq, release_none, NULL},
+    {"power_vector_iterate_omp", NEED_TRIDIAG | NEED_PING_PONG, 0,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 1, 0,
+     run_power_vector_iterate_omp, release_none, NULL},
+    {"power_vector_tiled_seq", NEED_TRIDIAG, 1,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 1,
+     run_power_vector_tiled_seq, release_vec, NULL},
+    {"power_vector_tiled_omp", NEED_TRIDIAG, 0,
+     TRIDIAG_MATVEC_BYTES, TRIDIAG_MATVEC_OPS, 0, 1,
+     run_power_vector_tiled_omp, release_vec, NULL},
+    {"square_seq", NEED_TRIDIAG, 1,
+     SQUARE_TRIDIAG_BYTES, SQUARE_TRIDIAG_OPS, 0, 0,
+     run_square_seq, release_penta, NULL},
+    {"square_omp", NEED_TRIDIAG, 0,
+     SQUARE_TRIDIAG_BYTES, SQUARE_TRIDIAG_OPS, 0, 0,
+     run_square_omp, release_penta, NULL},
+    {"square_int8_omp", NEED_INT8, 0,
+     SQUARE8_TRIDIAG_BYTES, SQUARE_TRIDIAG_OPS, 0, 0,
+     run_square_int8_omp, release_penta16, NULL},
+    {"cube_seq", NEED_SQUARE, 1,
+     CUBE_TRIDIAG_BYTES, CUBE_TRIDIAG_OPS, 0, 0,
+     run_cube_seq, release_hepta, NULL},
+    {"cube_omp", NEED_SQUARE, 0,
+     CUBE_TRIDIAG_BYTES, CUBE_TRIDIAG_OPS, 0, 0,
+     run_cube_omp, release_hepta, NULL},
+    {"band_power_omp", NEED_BAND, 0,
+     0, 0, 0, 0,
+     run_band_power_omp, release_band, band_cost},
+    {"series_seq", 0, 1,
+     SERIES_BYTES, SERIES_OPS, 0, 0,
+     run_series_seq, release_none, NULL},
+    {"series_omp", 0, 0,
+     SERIES_BYTES, SERIES_OPS, 0, 0,
+     run_series_omp, release_none, NULL},
+    {"series_repro_omp", 0, 0,
+     SERIES_BYTES, SERIES_OPS, 0, 0,
+     run_series_repro_omp, release_none, NULL},
+    {"series_simd_seq", NEED_SERIES_SIMD, 1,
+     SERIES_BYTES, SERIES_OPS, 0, 0,
+     run_series_simd_seq, release_none, NULL},
+    {"series_simd_omp", NEED_SERIES_SIMD, 0,
+     SERIES_BYTES, SERIES_OPS, 0, 0,
+     run_series_simd_omp, release_none, NULL},
+    {"engine_ex1_seq", 0, 1,
+     SERIES_BYTES, SERIES_OPS, 0, 0,
+     run_engine_ex1_seq, release_none, NULL},
+    {"engine_ex1_omp", 0, 0,
+     SERIES_BYTES, SERIES_OPS, 0, 0,
+     run_engine_ex1_omp, release_none, NULL},
+    {"engine_basel_omp", 0, 0,
+     SERIES_BYTES, BASEL_OPS, 0, 0,
+     run_engine_basel_omp, release_none, NULL},
+    {"engine_alt_harmonic_omp", 0, 0,
+     SERIES_BYTES, ALT_HARMONIC_OPS, 0, 0,
+     run_engine_alt_harmonic_omp, release_none, NULL},
+};
+
+static const int nkernels = sizeof(kernels) / sizeof(kernels[0]);
+
+static const BenchKernel *find_kernel(const char *name) {
+  for (int i = 0; i < nkernels; i++) {
+    if (strcmp(kernels[i].name, name) == 0)
+      return &kernels[i];
+  }
+  return NULL;
+}
+
+// ################################################################################
+// Data
+// ################################################################################
+
+static void prepare(BenchData *d, int needs) {
+  int n = d->n;
+  int nt = d->num_threads;
+
+  if ((needs & NEED_DENSE) && d->dense == NULL)
+    d->dense = random_tridiagonal_matrix(n);
+
+  if ((needs & (NEED_TRIDIAG | NEED_SQUARE | NEED_PACKED | NEED_INT8 |
+                NEED_BAND)) &&
+      d->A == NULL) {
+    d->A = random_opti_tridiagonal_matrix_first_touch(n, nt);
+    band_file_save_input(d->A);
+  }
+
+  if ((needs & NEED_SQUARE) && d->A2 == NULL)
+    d->A2 = compute_square_tridiagonal_omp(d->A, nt);
+
+  if ((needs & NEED_PACKED) && d->packed == NULL)
+    d->packed = pack_tridiagonal(d->A);
+
+  if ((needs & NEED_INT8) && d->A8 == NULL) {
+    d->A8 = narrow_tridiagonal8(d->A, nt);
+    d->vec8 = narrow_vec8(d->vec, n, nt);
+  }
+
+  if ((needs & NEED_BAND) && d->band == NULL)
+    d->band = band_from_tridiagonal(d->A);
+
+  if ((needs & NEED_PING_PONG) && d->iter_x == NULL) {
+    d->iter_x = alloc_vec_first_touch(n, nt);
+    d->iter_work = alloc_vec_first_touch(n, nt);
+  }
+
+  if (needs & NEED_SIMD)
+    tridiag_simd_init();
+
+  if (needs & NEED_SERIES_SIMD)
+    series_simd_init();
+}
+
+static void release_data(BenchData *d) {
+  if (d->dense) {
+    for (int i = 0; i < d->n; i++)
+      free(d->dense[i]);
+    free(d->dense);
+  }
+  if (d->file) {
+    band_file_close(d->file);
+  } else if (d->A) {
+    free(d->A->lower);
+    free(d->A->main);
+    free(d->A->upper);
+    free(d->A);
+  }
+  free_penta(d->A2);
+  free_packed_tridiagonal(d->packed);
+  free_tridiagonal8(d->A8);
+  free(d->vec8);
+  free_band(d->band);
+  free(d->iter_x);
+  free(d->iter_work);
+  free(d->vec);
+}
+
+// ################################################################################
+// Timing
+// ################################################################################
+
+// Streams the flush buffer with the benchmark's thread count so every core's
+// private caches are evicted too, not only the shared one
+static void flush_caches(unsigned char *buf, size_t bytes, int num_threads) {
+  static volatile unsigned long long sink;
+  unsigned long long acc = 0;
+
+#pragma omp parallel for schedule(static) num_threads(num_threads)           \
+    reduction(+ : acc)
+  for (size_t i = 0; i < bytes; i += 64) {
+    buf[i]++;
+    acc += buf[i];
+  }
+
+  sink += acc;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static BenchStats compute_stats(const double *times, int reps) {
+  BenchStats s;
+  double *sorted = malloc(reps * sizeof(double));
+  memcpy(sorted, times, reps * sizeof(double));
+  qsort(sorted, reps, sizeof(double), compare_double);
+
+  s.min = sorted[0];
+  s.median = reps % 2 ? sorted[reps / 2]
+                      : 0.5 * (sorted[reps / 2 - 1] + sorted[reps / 2]);
+
+  double sum = 0;
+  for (int r = 0; r < reps; r++)
+    sum += times[r];
+  s.mean = sum / reps;
+
+  double var = 0;
+  for (int r = 0; r < reps; r++)
+    var += (times[r] - s.mean) * (times[r] - s.mean);
+  s.stddev = reps > 1 ? sqrt(var / (reps - 1)) : 0;
+
+  free(sorted);
+  return s;
+}
+
+static void log_stats(const char *filename, const char *kernel, int n,
+                      int nthreads, int reps, int cold, const BenchStats *s) {
+  FILE *file = fopen(filename, "r");
+  int write_header = 0;
+  if (file == NULL) {
+    write_header = 1;
+  } else {
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+      write_header = 1;
+    }
+    fclose(file);
+  }
+
+  file = fopen(filename, "a");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open file %s for writing\n", filename);
+    return;
+  }
+
+  if (write_header) {
+    fprintf(file, "method,size,nb_proc,reps,mode,min,median,mean,stddev,gbs,"
+                  "gops,intensity,roofline\n");
+  }
+
+  fprintf(file, "%s,%d,%d,%d,%s,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n", kernel,
+          n, nthreads, reps, cold ? "cold" : "warm", s->min, s->median, s->mean,
+          s->stddev, s->gbs, s->gops, s->intensity, s->roofline);
+  fclose(file);
+}
+
+static void bench_kernel(const BenchKernel *kern, BenchData *d, int reps,
+                         int warmup, unsigned char *flush, size_t flush_bytes,
+                         const char *csv) {
+  int nthreads = kern->sequential ? 1 : d->num_threads;
+  double *times = malloc(reps * sizeof(double));
+
+  prepare(d, kern->needs);
+
+  for (int r = -warmup; r < reps; r++) {
+    // The iteration kernels overwrite x, restored before the flush
+    if (kern->needs & NEED_PING_PONG)
+      memcpy(d->iter_x, d->vec, d->n * sizeof(int));
+    if (flush)
+      flush_caches(flush, flush_bytes, d->num_threads);
+
+    double start_time = omp_get_wtime();
+    void *out = kern->run(d);
+    double end_time = omp_get_wtime();
+
+    kern->release(out);
+    if (r >= 0)
+      times[r] = end_time - start_time;
+  }
+
+  BenchStats s = compute_stats(times, reps);
+
+  double bytes = kern->bytes;
+  double ops = kern->ops;
+  if (kern->cost)
+    kern->cost(d, &bytes, &ops);
+  if (kern->k_products)
+    bytes *= d->k;
+  if (kern->k_products || kern->k_ops)
+    ops *= d->k;
+  bytes *= d->n;
+  ops *= d->n;
+
+  s.gbs = bytes / s.median * 1e-9;
+  s.gops = ops / s.median * 1e-9;
+  s.intensity = bytes > 0 ? ops / bytes : -1;
+  s.roofline = roofline_percent(bytes, ops, s.median, nthreads);
+
+  char intensity[16] = "-";
+  char roofline[16] = "-";
+  if (s.intensity >= 0)
+    snprintf(intensity, sizeof(intensity), "%.3f", s.intensity);
+  if (s.roofline >= 0)
+    snprintf(roofline, sizeof(roofline), "%.1f", s.roofline);
+
+  printf("%-24s %3d %10.6f %10.6f %10.6f %10.6f %8.2f %8.2f %7s %6s\n",
+         kern->name, nthreads, s.min, s.median, s.mean, s.stddev, s.gbs,
+         s.gops, intensity, roofline);
+  log_stats(csv, kern->name, d->n, nthreads, reps, flush != NULL, &s);
+
+  // Counters come from one extra repetition so they do not perturb the times
+  if (perf_enabled()) {
+    if (flush)
+      flush_caches(flush, flush_bytes, d->num_threads);
+    perf_start(nthreads);
+    void *out = kern->run(d);
+    perf_stop();
+    kern->release(out);
+    perf_log(csv, kern->name, d->n, nthreads);
+  }
+
+  free(times);
+}
+
+// ################################################################################
+// Command line
+// ################################################################################
+
+static void usage(const char *prog) {
+  printf("Usage: %s -k KERNEL[,KERNEL...] [options]\n"
+         "  -k, --kernel LIST   kernels to run (see --list)\n"
+         "  -n, --size N        matrix size (default 100000000)\n"
+         "  -t, --threads T     OpenMP threads (default omp_get_max_threads)\n"
+         "  -r, --reps R        timed repetitions (default 10)\n"
+         "  -w, --warmup W      untimed repetitions first (default 1)\n"
+         "  -p, --power K       exponent of the A^k kernels (default 8)\n"
+         "  -c, --cold          flush the caches before every repetition\n"
+         "      --flush-mb MB   size of the flush buffer (default 256)\n"
+         "  -o, --csv FILE      results file (default bench.csv)\n"
+         "  -l, --list          list the kernels\n",
+         prog);
+}
+
+static int parse_int(const char *arg, const char *what, int min) {
+  char *end;
+  long v = strtol(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || v < min || v > 2147483647L) {
+    fprintf(stderr, "Error: invalid %s '%s'\n", what, arg);
+    exit(1);
+  }
+  return (int)v;
+}
+
+int main(int argc, char **argv) {
+
+  BenchData d = {0};
+  d.n = 100000000;
+  d.k = 8;
+  d.num_threads = omp_get_max_threads();
+  int reps = 10;
+  int warmup = 1;
+  int cold = 0;
+  int flush_mb = 256;
+  const char *csv = "bench.csv";
+  char *list = NULL;
+
+  static const struct option options[] = {
+      {"kernel", required_argument, NULL, 'k'},
+      {"size", required_argument, NULL, 'n'},
+      {"threads", required_argument, NULL, 't'},
+      {"reps", required_argument, NULL, 'r'},
+      {"warmup", required_argument, NULL, 'w'},
+      {"power", required_argument, NULL, 'p'},
+      {"cold", no_argument, NULL, 'c'},
+      {"flush-mb", required_argument, NULL, 'f'},
+      {"csv", required_argument, NULL, 'o'},
+      {"list", no_argument, NULL, 'l'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "k:n:t:r:w:p:co:lh", options,
+                            NULL)) != -1) {
+    switch (opt) {
+    case 'k':
+      list = optarg;
+      break;
+    case 'n':
+      d.n = parse_int(optarg, "size", 4);
+      break;
+    case 't':
+      d.num_threads = parse_int(optarg, "thread count", 1);
+      break;
+    case 'r':
+      reps = parse_int(optarg, "repetition count", 1);
+      break;
+    case 'w':
+      warmup = parse_int(optarg, "warm-up count", 0);
+      break;
+    case 'p':
+      d.k = parse_int(optarg, "power", 1);
+      break;
+    case 'c':
+      cold = 1;
+      break;
+    case 'f':
+      flush_mb = parse_int(optarg, "flush size", 1);
+      break;
+    case 'o':
+      csv = optarg;
+      break;
+    case 'l':
+      for (int i = 0; i < nkernels; i++)
+        printf("%s\n", kernels[i].name);
+      return 0;
+    case 'h':
+      usage(argv[0]);
+      return 0;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (list == NULL) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  d.file = band_file_open_input();
+  if (d.file != NULL) {
+    d.A = band_file_tridiagonal(d.file);
+    d.n = d.A->n;
+  }
+
+  // Check every name before generating anything
+  char *names = strdup(list);
+  for (char *name = strtok(names, ","); name; name = strtok(NULL, ",")) {
+    const BenchKernel *kern = find_kernel(name);
+    if (kern == NULL) {
+      fprintf(stderr, "Error: unknown kernel '%s' (see --list)\n", name);
+      return 1;
+    }
+    if ((kern->needs & NEED_DENSE) && d.n > DENSE_MAX_N) {
+      fprintf(stderr, "Error: %s needs n <= %d (n = %d)\n", name,
+              DENSE_MAX_N, d.n);
+      return 1;
+    }
+  }
+  free(names);
+
+  unsigned char *flush = NULL;
+  size_t flush_bytes = (size_t)flush_mb << 20;
+  if (cold) {
+    flush = malloc(flush_bytes);
+    if (flush == NULL) {
+      fprintf(stderr, "Error: Could not allocate %d MB flush buffer\n",
+              flush_mb);
+      return 1;
+    }
+    memset(flush, 0, flush_bytes);
+  }
+
+  init_random();
+  d.vec = random_vec_first_touch(d.n, d.num_threads);
+
+  printf("n = %d, %d threads, %d repetitions after %d warm-up, %s caches\n",
+         d.n, d.num_threads, reps, warmup, cold ? "cold" : "warm");
+  printf("%-24s %3s %10s %10s %10s %10s %8s %8s %7s %6s\n", "kernel", "thr",
+         "min", "median", "mean", "stddev", "GB/s", "Gop/s", "op/B", "%roof");
+
+  names = strdup(list);
+  for (char *name = strtok(names, ","); name; name = strtok(NULL, ","))
+    bench_kernel(find_kernel(name), &d, reps, warmup, flush, flush_bytes, csv);
+  free(names);
+
+  free(flush);
+  release_data(&d);
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// STREAM-style bandwidth probe: copy, scale, add and triad on three double
+// arrays, for each thread count. Writes the best rate of each kernel (GB/s,
+// counted without write-allocate like STREAM) to stream.csv, which the
+// roofline report of bench and the programs reads back.
+//
+// Usage: stream_probe [-n ELEMENTS] [-r REPS] [-o CSV] [THREADS...]
+//   ELEMENTS per array (default 2^25, i.e. 256 MB each; keep the three
+//   arrays well above the last level cache). Without THREADS, powers of two
+//   up to omp_get_max_threads() and that count itself are measured.
+
+#define SCALAR 3.0
+
+static double *alloc_array(long n) {
+  double *p = malloc(n * sizeof(double));
+  if (p == NULL) {
+    fprintf(stderr, "Error: Could not allocate array of size %ld\n", n);
+    exit(1);
+  }
+  return p;
+}
+
+// Best GB/s of each kernel over reps runs, arrays first touched by the same
+// threads and static partition as the kernels
+static void probe(long n, int reps, int num_threads, double best[4]) {
+  double *a = alloc_array(n);
+  double *b = alloc_array(n);
+  double *c = alloc_array(n);
+
+  omp_set_dynamic(0);
+  omp_set_num_threads(num_threads);
+
+#pragma omp parallel for schedule(static)
+  for (long i = 0; i < n; i++) {
+    a[i] = 1.0;
+    b[i] = 2.0;
+    c[i] = 0.0;
+  }
+
+  const double bytes[4] = {16.0 * n, 16.0 * n, 24.0 * n, 24.0 * n};
+  double expect_a = 1.0, expect_b = 2.0, expect_c = 0.0;
+  for (int k = 0; k < 4; k++)
+    best[k] = 0;
+
+  for (int r = 0; r < reps; r++) {
+    double t[5];
+
+    t[0] = omp_get_wtime();
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; i++)
+      c[i] = a[i];
+    t[1] = omp_get_wtime();
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; i++)
+      b[i] = SCALAR * c[i];
+    t[2] = omp_get_wtime();
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; i++)
+      c[i] = a[i] + b[i];
+    t[3] = omp_get_wtime();
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; i++)
+      a[i] = b[i] + SCALAR * c[i];
+    t[4] = omp_get_wtime();
+
+    // Like STREAM, the first pass is not counted
+    if (r > 0 || reps == 1) {
+      for (int k = 0; k < 4; k++) {
+        double rate = bytes[k] / (t[k + 1] - t[k]) * 1e-9;
+        if (rate > best[k])
+          best[k] = rate;
+      }
+    }
+
+    expect_c = expect_a;
+    expect_b = SCALAR * expect_c;
+    expect_c = expect_a + expect_b;
+    expect_a = expect_b + SCALAR * expect_c;
+  }
+
+  if (a[n / 2] != expect_a || b[n / 2] != expect_b || c[n / 2] != expect_c) {
+    fprintf(stderr, "Error: stream results do not validate\n");
+    exit(1);
+  }
+
+  free(a);
+  free(b);
+  free(c);
+}
+
+int main(int argc, char **argv) {
+
+  long n = 1L << 25;
+  int reps = 10;
+  const char *csv = "stream.csv";
+  int threads[64];
+  int nthreads = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      n = atol(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      reps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      csv = argv[++i];
+    } else if (nthreads < 64 && atoi(argv[i]) > 0) {
+      threads[nthreads++] = atoi(argv[i]);
+    } else {
+      fprintf(stderr, "Usage: %s [-n ELEMENTS] [-r REPS] [-o CSV] "
+                      "[THREADS...]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (n < 2 || reps < 1) {
+    fprintf(stderr, "Error: need at least 2 elements and 1 repetition\n");
+    return 1;
+  }
+
+  if (nthreads == 0) {
+    int max = omp_get_max_threads();
+    for (int t = 1; t < max && nthreads < 63; t *= 2)
+      threads[nthreads++] = t;
+    threads[nthreads++] = max;
+  }
+
+  FILE *file = fopen(csv, "w");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open file %s for writing\n", csv);
+    return 1;
+  }
+  fprintf(file, "threads,copy,scale,add,triad\n");
+
+  printf("%ld elements per array (%.1f MB), best of %d\n", n,
+         n * sizeof(double) / 1e6, reps);
+  printf("%7s %10s %10s %10s %10s  (GB/s)\n", "threads", "copy", "scale",
+         "add", "triad");
+
+  for (int k = 0; k < nthreads; k++) {
+    double best[4];
+    probe(n, reps, threads[k], best);
+    printf("%7d %10.2f %10.2f %10.2f %10.2f\n", threads[k], best[0], best[1],
+           best[2], best[3]);
+    fprintf(file, "%d,%lf,%lf,%lf,%lf\n", threads[k], best[0], best[1],
+            best[2], best[3]);
+  }
+
+  fclose(file);
+  return 0;
+}
@@ -1,44 +1,281 @@
 #include <mpi.h>
+#include <omp.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../utils/checkpoint.h"
+#include "../utils/repro.h"
+#include "../utils/series.h"
+#include "../utils/series_simd.h"
+#include "../utils/series_terms.h"
 #include "../utils/utils.h"
 
-double fn(int i) {
-    return 1.0 / ((double)i * (i + 1));
+// Generic engine kernels for the same series (ex1_engine_mpi and friends)
+#define SERIES_NAME ex1_engine
+#define SERIES_TERM(i) ex1_term((double)(i))
+#define SERIES_TERM_D(d, i) ex1_term(d)
+#include "../utils/series_engine.h"
+
+// Terms summed between two looks at the clock of a checkpointed run
+#define CHECKPOINT_CHUNK (1LL << 27)
+
+// Contiguous block of terms of a rank (a stride of size would defeat the
+// vector kernel)
+void rank_block(long long n, int rank, int size, long long* first, long long* last) {
+    long long chunk = (n + size - 1) / size;
+    *first = 1 + rank * chunk;
+    *last = *first + chunk - 1 < n ? *first + chunk - 1 : n;
+}
+
+// first .. last with compensation, on num_threads threads when above 1
+double range_sum(long long first, long long last, int num_threads) {
+    if (num_threads > 1) {
+        return omp_simd_series_range(first, last, num_threads);
+    }
+    return series_simd_range(first, last);
+}
+
+// Block of the rank, checkpointed when SERIES_CHECKPOINT is set: the block
+// goes by chunks and the partial sum is saved every checkpoint_interval()
+// seconds, then once more when the block is done (removed by
+// finish_checkpoint once every rank is done).
+double checkpointed_sum(const char* name, long long n, int rank, int size, int num_threads) {
+    Checkpoint c = {0};
+    rank_block(n, rank, size, &c.first, &c.last);
+
+    char* path = checkpoint_path(name, rank);
+    if (path == NULL) {
+        return range_sum(c.first, c.last, num_threads);
+    }
+
+    c.rank = rank;
+    c.size = size;
+    c.next = c.first;
+    if (checkpoint_load(path, &c)) {
+        printf("rank %d: %s resumes at %lld of %lld .. %lld\n", rank, name, c.next, c.first,
+               c.last);
+    }
+
+    double every = checkpoint_interval();
+    double saved = MPI_Wtime();
+    while (c.next <= c.last) {
+        long long hi = c.last - c.next >= CHECKPOINT_CHUNK ? c.next + CHECKPOINT_CHUNK - 1 : c.last;
+        double part = range_sum(c.next, hi, num_threads);
+
+        double y = part - c.comp;
+        double t = c.sum + y;
+        c.comp = (t - c.sum) - y;
+        c.sum = t;
+        c.next = hi + 1;
+
+        if (c.next > c.last || MPI_Wtime() - saved >= every) {
+            checkpoint_save(path, &c);
+            saved = MPI_Wtime();
+        }
+    }
+
+    free(path);
+    return c.sum - c.comp;
+}
+
+// Drops the checkpoints of a run once its reduction is complete everywhere
+void finish_checkpoint(const char* name, int rank) {
+    char* path = checkpoint_path(name, rank);
+    if (path != NULL) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        checkpoint_remove(path);
+        free(path);
+    }
 }
 
-double sum(int n, int rank, int size) {
-    double local_sum = 0.0;
+// Subtrees of the fixed tree per rank when it is split: the work of a rank
+// then differs from the average by at most about one subtree in 16
+#define REPRO_SUBTREES_PER_RANK 16
 
-    for (int i = rank + 1; i <= n; i += size) {
-        local_sum += fn(i);
+static double block_sum(long long b, void* ctx) {
+    return series_block_sum(b, *(const long long*)ctx);
+}
+
+// Reproducible sum: the fixed tree of repro.h is cut into whole subtrees and
+// every rank sums a contiguous run of them with the same additions as
+// repro_combine. Rank 0 gathers one double per subtree (fewer than
+// 2 * REPRO_SUBTREES_PER_RANK per rank) and adds them along the top of the
+// tree, so the result (on rank 0) has the same bits for any size.
+double repro_sum(long long n, int rank, int size) {
+    long long nblocks = repro_nblocks(n);
+    long long nparts = (long long)REPRO_SUBTREES_PER_RANK * size;
+    long long nsub = repro_subtrees(nblocks, nparts, NULL, NULL);
+    long long* first = malloc(nsub * sizeof(long long));
+    long long* count = malloc(nsub * sizeof(long long));
+    repro_subtrees(nblocks, nparts, first, count);
+
+    int* counts = malloc(size * sizeof(int));
+    int* displs = malloc(size * sizeof(int));
+    for (int r = 0; r < size; r++) {
+        displs[r] = (int)(nsub * r / size);
+        counts[r] = (int)(nsub * (r + 1) / size) - displs[r];
+    }
+
+    double* local = malloc((counts[rank] + 1) * sizeof(double));
+    for (int s = 0; s < counts[rank]; s++) {
+        int t = displs[rank] + s;
+        local[s] = repro_tree_sum(first[t], count[t], block_sum, &n);
+    }
+
+    double* sums = NULL;
+    if (rank == 0) {
+        sums = malloc(nsub * sizeof(double));
+    }
+    MPI_Gatherv(local, counts[rank], MPI_DOUBLE, sums, counts, displs, MPI_DOUBLE, 0,
+                MPI_COMM_WORLD);
+
+    double total = 0.0;
+    if (rank == 0) {
+        total = repro_combine_subtrees(sums, nblocks, nparts);
+        free(sums);
     }
 
-    return local_sum;
+    free(local);
+    free(counts);
+    free(displs);
+    free(first);
+    free(count);
+    return total;
 }
 
+// Usage: mpirun -np RANKS ex1_mpi [N] [THREADS_PER_RANK] [MODE]
+//   THREADS_PER_RANK defaults to OMP_NUM_THREADS (or the number of cores),
+//   e.g. one rank per socket or NUMA node and one thread per core.
+//   MODE is mpi, repro, hybrid, engine or all (default). For very long runs pick one
+//   and set SERIES_CHECKPOINT (see checkpoint.h) to be able to resume.
 int main(int argc, char** argv) {
-    int rank, size;
-    int n = 1000000000;
+    int rank, size, provided;
+    long long n = 1000000000;
+    int num_threads = omp_get_max_threads();
+    const char* mode = "all";
     double local_sum, total_sum = 0.0;
     double start_time, end_time;
 
-    MPI_Init(&argc, &argv);
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    start_time = MPI_Wtime();
+    if (argc > 1) {
+        n = atoll(argv[1]);
+    }
+    if (argc > 2) {
+        num_threads = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        mode = argv[3];
+    }
+    int run_mpi = strcmp(mode, "all") == 0 || strcmp(mode, "mpi") == 0;
+    int run_repro = strcmp(mode, "all") == 0 || strcmp(mode, "repro") == 0;
+    int run_hybrid = strcmp(mode, "all") == 0 || strcmp(mode, "hybrid") == 0;
+    int run_engine = strcmp(mode, "all") == 0 || strcmp(mode, "engine") == 0;
+    if (n < 1 || num_threads < 1 || !(run_mpi || run_repro || run_hybrid || run_engine)) {
+        if (rank == 0) {
+            fprintf(stderr,
+                    "Error: Usage: %s [N] [THREADS_PER_RANK] [mpi|repro|hybrid|engine|all]\n",
+                    argv[0]);
+        }
+        MPI_Finalize();
+        exit(1);
+    }
+    if (provided < MPI_THREAD_FUNNELED && rank == 0) {
+        fprintf(stderr, "Warning: MPI does not provide MPI_THREAD_FUNNELED\n");
+    }
 
-    local_sum = sum(n, rank, size);
+    series_simd_init();
 
-    MPI_Reduce(&local_sum, &total_sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (run_mpi) {
+        perf_start(1);
+        start_time = MPI_Wtime();
 
-    end_time = MPI_Wtime();
+        local_sum = checkpointed_sum("mpi", n, rank, size, 1);
 
-    if (rank == 0) {
-        printf("time: %f seconds\n", end_time - start_time);
-        printf("%f\n", total_sum);
+        MPI_Reduce(&local_sum, &total_sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+        end_time = MPI_Wtime();
+        perf_stop();
+        finish_checkpoint("mpi", rank);
+
+        if (rank == 0) {
+            printf("time: %f seconds\n", end_time - start_time);
+            printf("%f\n", total_sum);
+
+            log_execution_time("ex1.csv", "mpi", n, size, end_time - start_time);
+        }
+    }
+
+    if (run_repro) {
+        perf_start(1);
+        start_time = MPI_Wtime();
+
+        total_sum = repro_sum(n, rank, size);
+
+        end_time = MPI_Wtime();
+        perf_stop();
+
+        if (rank == 0) {
+            printf("reproducible time: %f seconds\n", end_time - start_time);
+            printf("%a\n", total_sum);
+
+            log_execution_time("ex1.csv", "mpi_repro", n, size, end_time - start_time);
+        }
+    }
+
+    // Hybrid run, timed per level: the threaded sum inside each rank, then
+    // the reduction between ranks (which includes waiting for the slowest)
+    if (run_hybrid) {
+        double compute_time, reduce_time, compute_min, compute_max;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        perf_start(num_threads);
+        start_time = MPI_Wtime();
+
+        local_sum = checkpointed_sum("hybrid", n, rank, size, num_threads);
+        compute_time = MPI_Wtime() - start_time;
+
+        MPI_Reduce(&local_sum, &total_sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+        end_time = MPI_Wtime();
+        perf_stop();
+        reduce_time = end_time - start_time - compute_time;
+        finish_checkpoint("hybrid", rank);
+
+        MPI_Reduce(&compute_time, &compute_min, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&compute_time, &compute_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            printf("hybrid %d ranks x %d threads time: %f seconds\n", size, num_threads,
+                   end_time - start_time);
+            printf("  threads (per rank): min %f max %f seconds\n", compute_min, compute_max);
+            printf("  ranks (reduce on rank 0): %f seconds\n", reduce_time);
+            printf("%f\n", total_sum);
+
+            log_execution_time("ex1.csv", "hybrid", n, size * num_threads, end_time - start_time);
+            log_execution_time("ex1.csv", "hybrid_threads", n, size * num_threads, compute_max);
+            log_execution_time("ex1.csv", "hybrid_ranks", n, size * num_threads, reduce_time);
+        }
+    }
+
+    if (run_engine) {
+        perf_start(num_threads);
+        start_time = MPI_Wtime();
+
+        total_sum = ex1_engine_mpi(n, num_threads, MPI_COMM_WORLD);
+
+        end_time = MPI_Wtime();
+        perf_stop();
+
+        if (rank == 0) {
+            printf("engine %d ranks x %d threads time: %f seconds\n", size, num_threads,
+                   end_time - start_time);
+            printf("%f\n", total_sum);
 
-        log_execution_time("ex1.csv", "mpi", n, size, end_time - start_time);
+            log_execution_time("ex1.csv", "engine", n, size * num_threads, end_time - start_time);
+        }
     }
 
     MPI_Finalize();
@@ -1,40 +1,62 @@
 #include <omp.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include "../utils/series.h"
+#include "../utils/series_simd.h"
 #include "../utils/utils.h"
 
-double fn(int i) {
-    return 1.0 / ((double)i * (i + 1));
-}
-
-
-double sum(int n, int nb_threads) {
-
-    double total = 0;
+// Usage: ex1_omp [N] [THREADS]
+int main(int argc, char** argv) {
 
+    int num_threads = 8;
+    long long n = 1000000000;
 
-    omp_set_num_threads(nb_threads);
-    #pragma omp parallel for reduction(+:total) schedule(static)
-    for (int i=1; i<=n; i++) {
-        total += fn(i);
+    if (argc > 1) {
+        n = atoll(argv[1]);
+    }
+    if (argc > 2) {
+        num_threads = atoi(argv[2]);
+    }
+    if (n < 1 || num_threads < 1) {
+        fprintf(stderr, "Error: Usage: %s [N] [THREADS]\n", argv[0]);
+        exit(1);
     }
 
-    return total;
-
-}
-
-int main() {
-
-    int num_threads = 8;
-    int n = 1000000000;
-
+    perf_start(num_threads);
     double start_time = omp_get_wtime();
-    double result = sum(n, num_threads);
+    double result = omp_series_sum(n, num_threads);
     double end_time = omp_get_wtime();
+    perf_stop();
 
     printf("time: %fseconds\n", end_time - start_time);
     printf("%f", result);
 
     log_execution_time("ex1.csv", "omp", n, num_threads, end_time - start_time);
 
+    // Reproducible reduction: same bits for any number of threads
+    perf_start(num_threads);
+    start_time = omp_get_wtime();
+    double result_repro = repro_series_sum(n, num_threads);
+    end_time = omp_get_wtime();
+    perf_stop();
+
+    printf("\nreproducible time: %fseconds\n", end_time - start_time);
+    printf("%a", result_repro);
+
+    log_execution_time("ex1.csv", "omp_repro", n, num_threads, end_time - start_time);
+
+    // Vectorized kernel with compensated (Kahan) lanes
+    series_simd_init();
+    perf_start(num_threads);
+    start_time = omp_get_wtime();
+    double result_simd = omp_simd_series_sum(n, num_threads);
+    end_time = omp_get_wtime();
+    perf_stop();
+
+    printf("\nSIMD (%s) time: %fseconds\n", series_simd_kernel(), end_time - start_time);
+    printf("%.17f (error %.3e)\n", result_simd, result_simd - (1.0 - 1.0 / ((double)n + 1)));
+
+    log_execution_time("ex1.csv", "omp_simd", n, num_threads, end_time - start_time);
+
     return 0;
 }
\ No newline at end of file
@@ -1,37 +1,47 @@
 #include <omp.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include "../utils/series.h"
+#include "../utils/series_simd.h"
 #include "../utils/utils.h"
 
-double fn(int i) {
-    return 1.0 / ((double)i * (i + 1));
-}
+// Usage: ex1_seq [N]
+int main(int argc, char** argv) {
 
+    int num_threads = 1;
+    long long n = 1000000000;
 
-double sum(int n) {
-
-    double total = 0;
-
-    for (int i=1; i<=n; i++) {
-        total += fn(i);
+    if (argc > 1) {
+        n = atoll(argv[1]);
+    }
+    if (n < 1) {
+        fprintf(stderr, "Error: Usage: %s [N]\n", argv[0]);
+        exit(1);
     }
 
-    return total;
-
-}
-
-int main() {
-
-    int num_threads = 1;
-    int n = 1000000000;
-
+    perf_start(1);
     double start_time = omp_get_wtime();
-    double result = sum(n);
+    double result = sequential_series_sum(n);
     double end_time = omp_get_wtime();
+    perf_stop();
 
     printf("time: %fseconds\n", end_time - start_time);
     printf("%f", result);
 
     log_execution_time("ex1.csv", "sequential", n, num_threads, end_time - start_time);
 
+    // Vectorized kernel with compensated (Kahan) lanes
+    series_simd_init();
+    perf_start(1);
+    start_time = omp_get_wtime();
+    double result_simd = simd_series_sum(n);
+    end_time = omp_get_wtime();
+    perf_stop();
+
+    printf("\nSIMD (%s) time: %fseconds\n", series_simd_kernel(), end_time - start_time);
+    printf("%.17f (error %.3e)\n", result_simd, result_simd - (1.0 - 1.0 / ((double)n + 1)));
+
+    log_execution_time("ex1.csv", "sequential_simd", n, num_threads, end_time - start_time);
+
     return 0;
 }
\ No newline at end of file
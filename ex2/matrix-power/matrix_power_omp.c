@@ -1,208 +1,221 @@
+#include "../../utils/band.h"
+#include "../../utils/band_file.h"
+#include "../../utils/narrow.h"
+#include "../../utils/power.h"
 #include "../../utils/utils.h"
 #include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-// Compute A^2 (Pentadiagonal) from A (Tridiagonal)
-PentaDiagMatrix *compute_square_tridiagonal_omp(TridiagMatrix *A,
-                                                int num_threads) {
-  int n = A->n;
-  PentaDiagMatrix *R = malloc(sizeof(PentaDiagMatrix));
-  R->n = n;
-  R->main = malloc(n * sizeof(int));
-  R->upper1 = malloc((n - 1) * sizeof(int));
-  R->upper2 = malloc((n - 2) * sizeof(int));
-  R->lower1 = malloc((n - 1) * sizeof(int));
-  R->lower2 = malloc((n - 2) * sizeof(int));
-
-  int *M = A->main;
-  int *U = A->upper;
-  int *L = A->lower;
-
-  omp_set_dynamic(0);
-  omp_set_num_threads(num_threads);
-  #pragma omp parallel for
+// Narrow A^2 against the int one, diagonal by diagonal
+static int penta16_equal(const PentaDiagMatrix16 *R, const PentaDiagMatrix *E) {
+  int n = E->n;
   for (int i = 0; i < n; i++) {
-    // 1. Main Diagonal (R_{i,i})
-    int val = M[i] * M[i];
-    if (i > 0)
-      val += L[i - 1] * U[i - 1];
-    if (i < n - 1)
-      val += U[i] * L[i];
-    R->main[i] = val;
-
-    // 2. Upper1 Diagonal (R_{i, i+1})
-    if (i < n - 1) {
-      R->upper1[i] = M[i] * U[i] + U[i] * M[i + 1];
-    }
-
-    // 3. Upper2 Diagonal (R_{i, i+2})
-    if (i < n - 2) {
-      R->upper2[i] = U[i] * U[i + 1];
-    }
-
-    // 4. Lower1 Diagonal (R_{i+1, i})
-    if (i < n - 1) {
-      R->lower1[i] = L[i] * M[i] + M[i + 1] * L[i];
-    }
-
-    // 5. Lower2 Diagonal (R_{i+2, i})
-    if (i < n - 2) {
-      R->lower2[i] = L[i + 1] * L[i];
-    }
+    if (R->main[i] != E->main[i])
+      return 0;
   }
-
-  return R;
-}
-
-// Compute A^3 (Heptadiagonal) from A (Tridiagonal) and A^2 (Pentadiagonal)
-HeptaDiagMatrix *compute_cube_tridiagonal_omp(TridiagMatrix *A,
-                                              PentaDiagMatrix *A2,
-                                              int num_threads) {
-  int n = A->n;
-  HeptaDiagMatrix *R = malloc(sizeof(HeptaDiagMatrix));
-  R->n = n;
-  R->main = malloc(n * sizeof(int));
-  R->upper1 = malloc((n - 1) * sizeof(int));
-  R->upper2 = malloc((n - 2) * sizeof(int));
-  R->upper3 = malloc((n - 3) * sizeof(int));
-  R->lower1 = malloc((n - 1) * sizeof(int));
-  R->lower2 = malloc((n - 2) * sizeof(int));
-  R->lower3 = malloc((n - 3) * sizeof(int));
-
-  int *M = A->main;
-  int *U = A->upper;
-  int *L = A->lower;
-
-  int *M2 = A2->main;
-  int *U1_2 = A2->upper1;
-  int *U2_2 = A2->upper2;
-  int *L1_2 = A2->lower1;
-  int *L2_2 = A2->lower2;
-
-  omp_set_dynamic(0);
-  omp_set_num_threads(num_threads);
-  #pragma omp parallel for
-  for (int i = 0; i < n; i++) {
-    // 1. Main Diagonal (j=i)
-    long long val = 0;
-    if (i > 0)
-      val += (long long)L[i - 1] * U1_2[i - 1];
-    val += (long long)M[i] * M2[i];
-    if (i < n - 1)
-      val += (long long)U[i] * L1_2[i];
-    R->main[i] = (int)val;
-
-    // 2. Upper1 (j=i+1)
-    if (i < n - 1) {
-      long long v = 0;
-      if (i > 0)
-        v += (long long)L[i - 1] * U2_2[i - 1];
-      v += (long long)M[i] * U1_2[i];
-      v += (long long)U[i] * M2[i + 1];
-      R->upper1[i] = (int)v;
-    }
-
-    // 3. Upper2 (j=i+2)
-    if (i < n - 2) {
-      long long v = 0;
-      v += (long long)M[i] * U2_2[i];
-      v += (long long)U[i] * U1_2[i + 1];
-      R->upper2[i] = (int)v;
-    }
-
-    // 4. Upper3 (j=i+3)
-    if (i < n - 3) {
-      long long v = 0;
-      v += (long long)U[i] * U2_2[i + 1];
-      R->upper3[i] = (int)v;
-    }
-
-    // 5. Lower1 (j=i-1)
-    if (i > 0) {
-      long long v = 0;
-      v += (long long)L[i - 1] * M2[i - 1];
-      v += (long long)M[i] * L1_2[i - 1];
-      if (i < n - 1)
-        v += (long long)U[i] * L2_2[i - 1];
-      R->lower1[i - 1] = (int)v;
-    }
-
-    // 6. Lower2 (j=i-2)
-    if (i > 1) {
-      long long v = 0;
-      v += (long long)L[i - 1] * L1_2[i - 2];
-      v += (long long)M[i] * L2_2[i - 2];
-      R->lower2[i - 2] = (int)v;
-    }
-
-    // 7. Lower3 (j=i-3)
-    if (i > 2) {
-      long long v = 0;
-      v += (long long)L[i - 1] * L2_2[i - 3];
-      R->lower3[i - 3] = (int)v;
-    }
+  for (int i = 0; i < n - 1; i++) {
+    if (R->lower1[i] != E->lower1[i] || R->upper1[i] != E->upper1[i])
+      return 0;
   }
-
-  return R;
+  for (int i = 0; i < n - 2; i++) {
+    if (R->lower2[i] != E->lower2[i] || R->upper2[i] != E->upper2[i])
+      return 0;
+  }
+  return 1;
 }
 
-void free_penta(PentaDiagMatrix *m) {
-  if (!m)
-    return;
-  free(m->main);
-  free(m->upper1);
-  free(m->upper2);
-  free(m->lower1);
-  free(m->lower2);
-  free(m);
+static int penta_equal(const PentaDiagMatrix *R, const PentaDiagMatrix *E) {
+  int n = E->n;
+  return memcmp(R->main, E->main, n * sizeof(int)) == 0 &&
+         memcmp(R->lower1, E->lower1, (n - 1) * sizeof(int)) == 0 &&
+         memcmp(R->upper1, E->upper1, (n - 1) * sizeof(int)) == 0 &&
+         memcmp(R->lower2, E->lower2, (n - 2) * sizeof(int)) == 0 &&
+         memcmp(R->upper2, E->upper2, (n - 2) * sizeof(int)) == 0;
 }
 
-void free_hepta(HeptaDiagMatrix *m) {
-  if (!m)
-    return;
-  free(m->main);
-  free(m->upper1);
-  free(m->upper2);
-  free(m->upper3);
-  free(m->lower1);
-  free(m->lower2);
-  free(m->lower3);
-  free(m);
+// Exits when R differs from the reference E, then frees E. Entries below
+// BAND_EXACT_MAX are exact in both, beyond it they may differ by rounding.
+static void check_band(const char *what, const BandMatrix *R, BandMatrix *E) {
+  double diff = band_max_diff(R, E);
+  if (diff > 1e-12 * band_max_abs(E)) {
+    fprintf(stderr, "Error: %s differs from the reference by %g\n", what,
+            diff);
+    exit(1);
+  }
+  free_band(E);
 }
 
-int main() {
+// MATRIX_FILE=path maps A from that band file (see band_file.h) instead of
+// generating it; when the file does not exist yet, the generated A is written
+// there for the next runs. MATRIX_POWER_FILE=prefix writes the computed A^2
+// and A^3 to prefix.A2 and prefix.A3. The power of band_power is the first
+// argument, 8 by default.
+int main(int argc, char **argv) {
   init_random();
 
   int n = 100000000;   // 100 Million
   int num_threads = 8; // Default to 8 threads
+  int k = 8;           // Power computed through band_power
+  if (argc > 1)
+    k = atoi(argv[1]);
+  if (k < 1) {
+    fprintf(stderr, "Error: the power must be positive\n");
+    exit(1);
+  }
 
-  printf("Generating Tridiagonal Matrix of size %d...\n", n);
-  TridiagMatrix *A = random_opti_tridiagonal_matrix(n);
+  BandFile *file = band_file_open_input();
+  TridiagMatrix *A;
+  if (file != NULL) {
+    A = band_file_tridiagonal(file);
+    n = A->n;
+  } else {
+    printf("Generating Tridiagonal Matrix of size %d...\n", n);
+    A = random_opti_tridiagonal_matrix_first_touch(n, num_threads);
+    band_file_save_input(A);
+  }
+  report_numa_placement("main", A->main, (size_t)n * sizeof(int));
+  report_numa_placement("lower", A->lower, (size_t)(n - 1) * sizeof(int));
+  report_numa_placement("upper", A->upper, (size_t)(n - 1) * sizeof(int));
 
   printf("Computing A^2 (OpenMP with %d threads)...\n", num_threads);
+  perf_start(num_threads);
   double start = omp_get_wtime();
   PentaDiagMatrix *A2 = compute_square_tridiagonal_omp(A, num_threads);
   double end = omp_get_wtime();
+  perf_stop();
   printf("A^2 computed in %f seconds.\n", end - start);
   log_execution_time("matrix_power2.csv", "omp", n, num_threads,
                      end - start);
 
   printf("Computing A^3 (OpenMP with %d threads)...\n", num_threads);
+  perf_start(num_threads);
   start = omp_get_wtime();
   HeptaDiagMatrix *A3 = compute_cube_tridiagonal_omp(A, A2, num_threads);
   end = omp_get_wtime();
+  perf_stop();
   printf("A^3 computed in %f seconds.\n", end - start);
   log_execution_time("matrix_power3.csv", "omp", n, num_threads,
                      end - start);
 
+  const char *output = getenv("MATRIX_POWER_FILE");
+  if (output != NULL && output[0] != '\0') {
+    // Tagged with the seed of A, which a mapped file may not share with
+    // HPC_SEED
+    uint64_t seed = file != NULL ? file->header.seed : get_seed();
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.A2", output);
+    band_file_write_penta(path, A2, seed);
+    snprintf(path, sizeof(path), "%s.A3", output);
+    band_file_write_hepta(path, A3, seed);
+    printf("Wrote A^2 and A^3 to %s.A2 and %s.A3\n", output, output);
+  }
+
+  // A^2 on int8 storage (int16 result). A generated here is regenerated
+  // straight into int8 storage; a mapped A is narrowed.
+  TridiagMatrix8 *A8 = file == NULL
+                           ? random_opti_tridiagonal_matrix8(n, num_threads)
+                           : narrow_tridiagonal8(A, num_threads);
+  printf("Computing A^2 on int8 storage (OpenMP with %d threads)...\n",
+         num_threads);
+  perf_start(num_threads);
+  start = omp_get_wtime();
+  PentaDiagMatrix16 *A2_16 = compute_square_tridiagonal8_omp(A8, num_threads);
+  end = omp_get_wtime();
+  perf_stop();
+  printf("A^2 computed in %f seconds.\n", end - start);
+  log_execution_time("matrix_power2.csv", "omp_int8", n, num_threads,
+                     end - start);
+  if (!penta16_equal(A2_16, A2)) {
+    fprintf(stderr, "Error: int8 A^2 differs from the int one\n");
+    exit(1);
+  }
+  free_tridiagonal8(A8);
+  free_penta16(A2_16);
+
+  // A^2 on int16 storage (int result)
+  TridiagMatrix16 *A16 = narrow_tridiagonal16(A, num_threads);
+  printf("Computing A^2 on int16 storage (OpenMP with %d threads)...\n",
+         num_threads);
+  perf_start(num_threads);
+  start = omp_get_wtime();
+  PentaDiagMatrix *A2_int16 =
+      compute_square_tridiagonal16_omp(A16, num_threads);
+  end = omp_get_wtime();
+  perf_stop();
+  printf("A^2 computed in %f seconds.\n", end - start);
+  log_execution_time("matrix_power2.csv", "omp_int16", n, num_threads,
+                     end - start);
+
+  if (!penta_equal(A2_int16, A2)) {
+    fprintf(stderr, "Error: int16 A^2 differs from the int one\n");
+    exit(1);
+  }
+  free_tridiagonal16(A16);
+  free_penta(A2_int16);
+
+  // Same products through the generic band storage
+  BandMatrix *B = band_from_tridiagonal(A);
+
+  printf("Computing A^2 with band_multiply (OpenMP with %d threads)...\n",
+         num_threads);
+  perf_start(num_threads);
+  start = omp_get_wtime();
+  BandMatrix *B2 = band_multiply(B, B, num_threads);
+  end = omp_get_wtime();
+  perf_stop();
+  printf("A^2 computed in %f seconds.\n", end - start);
+  log_execution_time("matrix_power2.csv", "omp_band", n, num_threads,
+                     end - start);
+
+  printf("Computing A^3 with band_multiply (OpenMP with %d threads)...\n",
+         num_threads);
+  perf_start(num_threads);
+  start = omp_get_wtime();
+  BandMatrix *B3 = band_multiply(B, B2, num_threads);
+  end = omp_get_wtime();
+  perf_stop();
+  printf("A^3 computed in %f seconds.\n", end - start);
+  log_execution_time("matrix_power3.csv", "omp_band", n, num_threads,
+                     end - start);
+
+  printf("Computing A^%d with band_power (OpenMP with %d threads)...\n", k,
+         num_threads);
+  perf_start(num_threads);
+  start = omp_get_wtime();
+  BandMatrix *Bk = band_power(B, k, num_threads);
+  end = omp_get_wtime();
+  perf_stop();
+  printf("A^%d computed in %f seconds.\n", k, end - start);
+  char filename[64];
+  snprintf(filename, sizeof(filename), "matrix_power%d.csv", k);
+  log_execution_time(filename, "omp_band", n, num_threads, end - start);
+
+  double max = band_max_abs(Bk);
+  printf("Largest entry of A^%d: %g%s\n", k, max,
+         max < BAND_EXACT_MAX ? "" : " (rounded to double)");
+
+  // A^2 and A^3 against the dedicated kernels, A^k against k - 1 products
+  check_band("band_multiply A^2", B2, band_from_penta(A2));
+  check_band("band_multiply A^3", B3, band_from_hepta(A3));
+  check_band("band_power", Bk, band_power_chain(B, k, num_threads));
+
   // Cleanup
-  free(A->main);
-  free(A->upper);
-  free(A->lower);
-  free(A);
+  if (file != NULL) {
+    band_file_close(file);
+  } else {
+    free(A->main);
+    free(A->upper);
+    free(A->lower);
+    free(A);
+  }
   free_penta(A2);
   free_hepta(A3);
+  free_band(B);
+  free_band(B2);
+  free_band(B3);
+  free_band(Bk);
 
   return 0;
 }
@@ -1,3 +1,6 @@
+#include "../../utils/band.h"
+#include "../../utils/band_file.h"
+#include "../../utils/power.h"
 #include "../../utils/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,230 +13,135 @@ double get_time() {
   return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
-// Compute A^2 (Pentadiagonal) from A (Tridiagonal)
-PentaDiagMatrix *compute_square_tridiagonal(TridiagMatrix *A) {
-  int n = A->n;
-  PentaDiagMatrix *R = malloc(sizeof(PentaDiagMatrix));
-  R->n = n;
-  R->main = malloc(n * sizeof(int));
-  R->upper1 = malloc((n - 1) * sizeof(int));
-  R->upper2 = malloc((n - 2) * sizeof(int));
-  R->lower1 = malloc((n - 1) * sizeof(int));
-  R->lower2 = malloc((n - 2) * sizeof(int));
-
-  // Access helpers (handling boundaries with 0)
-  // A->main[i] is valid for 0 <= i < n
-  // A->upper[i] is valid for 0 <= i < n-1 (corresponds to A_{i, i+1})
-  // A->lower[i] is valid for 0 <= i < n-1 (corresponds to A_{i+1, i})
-
-  // Notation:
-  // M[i] = A_{i,i}
-  // U[i] = A_{i, i+1}
-  // L[i] = A_{i+1, i}  => Note: A->lower[i] is A_{i+1, i}. Be careful with
-  // indices. Usually lower[i] means element at row i+1, col i.
-
-  int *M = A->main;
-  int *U = A->upper;
-  int *L = A->lower;
-
-  for (int i = 0; i < n; i++) {
-    // 1. Main Diagonal (R_{i,i})
-    // sum_k A_{ik} A_{ki}
-    // k = i-1: A_{i, i-1} * A_{i-1, i} = L[i-1] * U[i-1] (if i>0)
-    // k = i:   A_{i, i}   * A_{i, i}   = M[i]   * M[i]
-    // k = i+1: A_{i, i+1} * A_{i+1, i} = U[i]   * L[i]   (if i<n-1)
-
-    int val = M[i] * M[i];
-    if (i > 0)
-      val += L[i - 1] * U[i - 1];
-    if (i < n - 1)
-      val += U[i] * L[i];
-    R->main[i] = val;
-
-    // 2. Upper1 Diagonal (R_{i, i+1})
-    // sum_k A_{ik} A_{k, i+1}
-    // k = i:   A_{i, i}   * A_{i, i+1}   = M[i] * U[i]
-    // k = i+1: A_{i, i+1} * A_{i+1, i+1} = U[i] * M[i+1]
-    if (i < n - 1) {
-      R->upper1[i] = M[i] * U[i] + U[i] * M[i + 1];
-    }
-
-    // 3. Upper2 Diagonal (R_{i, i+2})
-    // sum_k A_{ik} A_{k, i+2}
-    // k = i+1: A_{i, i+1} * A_{i+1, i+2} = U[i] * U[i+1]
-    if (i < n - 2) {
-      R->upper2[i] = U[i] * U[i + 1];
-    }
-
-    // 4. Lower1 Diagonal (R_{i+1, i})
-    // sum_k A_{i+1, k} A_{k, i}
-    // k = i:   A_{i+1, i} * A_{i, i}   = L[i] * M[i]
-    // k = i+1: A_{i+1, i+1} * A_{i+1, i} = M[i+1] * L[i]
-    if (i < n - 1) {
-      R->lower1[i] = L[i] * M[i] + M[i + 1] * L[i];
-    }
-
-    // 5. Lower2 Diagonal (R_{i+2, i})
-    // sum_k A_{i+2, k} A_{k, i}
-    // k = i+1: A_{i+2, i+1} * A_{i+1, i} = L[i+1] * L[i]
-    if (i < n - 2) {
-      R->lower2[i] = L[i + 1] * L[i];
-    }
+// Exits when R differs from the reference E, then frees E. Entries below
+// BAND_EXACT_MAX are exact in both, beyond it they may differ by rounding.
+static void check_band(const char *what, const BandMatrix *R, BandMatrix *E) {
+  double diff = band_max_diff(R, E);
+  if (diff > 1e-12 * band_max_abs(E)) {
+    fprintf(stderr, "Error: %s differs from the reference by %g\n", what,
+            diff);
+    exit(1);
   }
-
-  return R;
-}
-
-// Compute A^3 (Heptadiagonal) from A (Tridiagonal) and A^2 (Pentadiagonal)
-// A^3 = A * A^2
-HeptaDiagMatrix *compute_cube_tridiagonal(TridiagMatrix *A,
-                                          PentaDiagMatrix *A2) {
-  int n = A->n;
-  HeptaDiagMatrix *R = malloc(sizeof(HeptaDiagMatrix));
-  R->n = n;
-  R->main = malloc(n * sizeof(int));
-  R->upper1 = malloc((n - 1) * sizeof(int));
-  R->upper2 = malloc((n - 2) * sizeof(int));
-  R->upper3 = malloc((n - 3) * sizeof(int));
-  R->lower1 = malloc((n - 1) * sizeof(int));
-  R->lower2 = malloc((n - 2) * sizeof(int));
-  R->lower3 = malloc((n - 3) * sizeof(int));
-
-  int *M = A->main;
-  int *U = A->upper;
-  int *L = A->lower;
-
-  int *M2 = A2->main;
-  int *U1_2 = A2->upper1;
-  int *U2_2 = A2->upper2;
-  int *L1_2 = A2->lower1;
-  int *L2_2 = A2->lower2;
-
-  for (int i = 0; i < n; i++) {
-    // A_{ik} is non-zero for k in {i-1, i, i+1}
-    // (A^3)_{ij} = L[i-1]*(A^2)_{i-1, j} + M[i]*(A^2)_{i, j} + U[i]*(A^2)_{i+1,
-    // j} Be careful with boundaries.
-
-    // 1. Main Diagonal (j=i)
-    long long val = 0;
-    if (i > 0)
-      val += (long long)L[i - 1] *
-             U1_2[i - 1]; // A_{i, i-1} * (A^2)_{i-1, i} = L[i-1] * U1_2[i-1]
-    val += (long long)M[i] * M2[i]; // A_{i, i}   * (A^2)_{i, i}
-    if (i < n - 1)
-      val += (long long)U[i] *
-             L1_2[i]; // A_{i, i+1} * (A^2)_{i+1, i} = U[i] * L1_2[i]
-    R->main[i] = (int)val;
-
-    // 2. Upper1 (j=i+1)
-    if (i < n - 1) {
-      long long v = 0;
-      if (i > 0)
-        v += (long long)L[i - 1] *
-             U2_2[i - 1]; // A_{i, i-1} * (A^2)_{i-1, i+1} = L[i-1] * U2_2[i-1]
-      v += (long long)M[i] * U1_2[i];   // A_{i, i} * (A^2)_{i, i+1}
-      v += (long long)U[i] * M2[i + 1]; // A_{i, i+1} * (A^2)_{i+1, i+1}
-      R->upper1[i] = (int)v;
-    }
-
-    // 3. Upper2 (j=i+2)
-    if (i < n - 2) {
-      long long v = 0;
-      // k=i-1: (A^2)_{i-1, i+2} is 0 (dist 3)
-      v += (long long)M[i] * U2_2[i];     // A_{i, i} * (A^2)_{i, i+2}
-      v += (long long)U[i] * U1_2[i + 1]; // A_{i, i+1} * (A^2)_{i+1, i+2}
-      R->upper2[i] = (int)v;
-    }
-
-    // 4. Upper3 (j=i+3)
-    if (i < n - 3) {
-      long long v = 0;
-      v += (long long)U[i] * U2_2[i + 1]; // A_{i, i+1} * (A^2)_{i+1, i+3}
-      R->upper3[i] = (int)v;
-    }
-
-    // 5. Lower1 (j=i-1) (row i, col i-1)
-    if (i > 0) {
-      long long v = 0;
-      v += (long long)L[i - 1] * M2[i - 1]; // A_{i, i-1} * (A^2)_{i-1, i-1}
-      v += (long long)M[i] * L1_2[i - 1];   // A_{i, i} * (A^2)_{i, i-1}
-      if (i < n - 1)
-        v += (long long)U[i] *
-             L2_2[i - 1]; // A_{i, i+1} * (A^2)_{i+1, i-1} = U[i] * L2_2[i-1]
-      R->lower1[i - 1] = (int)v;
-    }
-
-    // 6. Lower2 (j=i-2) (row i, col i-2)
-    if (i > 1) {
-      long long v = 0;
-      v += (long long)L[i - 1] * L1_2[i - 2]; // A_{i, i-1} * (A^2)_{i-1, i-2}
-      v += (long long)M[i] * L2_2[i - 2];     // A_{i, i} * (A^2)_{i, i-2}
-      R->lower2[i - 2] = (int)v;
-    }
-
-    // 7. Lower3 (j=i-3)
-    if (i > 2) {
-      long long v = 0;
-      v += (long long)L[i - 1] * L2_2[i - 3]; // A_{i, i-1} * (A^2)_{i-1, i-3}
-      R->lower3[i - 3] = (int)v;
-    }
-  }
-
-  return R;
-}
-
-void free_penta(PentaDiagMatrix *m) {
-  if (!m)
-    return;
-  free(m->main);
-  free(m->upper1);
-  free(m->upper2);
-  free(m->lower1);
-  free(m->lower2);
-  free(m);
+  free_band(E);
 }
 
-void free_hepta(HeptaDiagMatrix *m) {
-  if (!m)
-    return;
-  free(m->main);
-  free(m->upper1);
-  free(m->upper2);
-  free(m->upper3);
-  free(m->lower1);
-  free(m->lower2);
-  free(m->lower3);
-  free(m);
-}
-
-int main() {
+// MATRIX_FILE=path maps A from that band file (see band_file.h) instead of
+// generating it; when the file does not exist yet, the generated A is written
+// there for the next runs. MATRIX_POWER_FILE=prefix writes the computed A^2
+// and A^3 to prefix.A2 and prefix.A3. The power of band_power is the first
+// argument, 8 by default.
+int main(int argc, char **argv) {
   init_random();
 
   int n = 100000000; // 100 Million
-  printf("Generating Tridiagonal Matrix of size %d...\n", n);
-  TridiagMatrix *A = random_opti_tridiagonal_matrix(n);
+  int k = 8;         // Power computed through band_power
+  if (argc > 1)
+    k = atoi(argv[1]);
+  if (k < 1) {
+    fprintf(stderr, "Error: the power must be positive\n");
+    exit(1);
+  }
+
+  BandFile *file = band_file_open_input();
+  TridiagMatrix *A;
+  if (file != NULL) {
+    A = band_file_tridiagonal(file);
+    n = A->n;
+  } else {
+    printf("Generating Tridiagonal Matrix of size %d...\n", n);
+    A = random_opti_tridiagonal_matrix(n);
+    band_file_save_input(A);
+  }
 
   printf("Computing A^2 (Sequential)...\n");
+  perf_start(1);
   double start = get_time();
   PentaDiagMatrix *A2 = compute_square_tridiagonal(A);
   double end = get_time();
+  perf_stop();
   printf("A^2 computed in %f seconds.\n", end - start);
   log_execution_time("matrix_power2.csv", "sequential", n, 1, end - start);
 
   printf("Computing A^3 (Sequential)...\n");
+  perf_start(1);
   start = get_time();
   HeptaDiagMatrix *A3 = compute_cube_tridiagonal(A, A2);
   end = get_time();
+  perf_stop();
   printf("A^3 computed in %f seconds.\n", end - start);
   log_execution_time("matrix_power3.csv", "sequential", n, 1, end - start);
 
+  const char *output = getenv("MATRIX_POWER_FILE");
+  if (output != NULL && output[0] != '\0') {
+    // Tagged with the seed of A, which a mapped file may not share with
+    // HPC_SEED
+    uint64_t seed = file != NULL ? file->header.seed : get_seed();
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.A2", output);
+    band_file_write_penta(path, A2, seed);
+    snprintf(path, sizeof(path), "%s.A3", output);
+    band_file_write_hepta(path, A3, seed);
+    printf("Wrote A^2 and A^3 to %s.A2 and %s.A3\n", output, output);
+  }
+
+  // Same products through the generic band storage
+  BandMatrix *B = band_from_tridiagonal(A);
+
+  printf("Computing A^2 with band_multiply (Sequential)...\n");
+  perf_start(1);
+  start = get_time();
+  BandMatrix *B2 = band_multiply(B, B, 1);
+  end = get_time();
+  perf_stop();
+  printf("A^2 computed in %f seconds.\n", end - start);
+  log_execution_time("matrix_power2.csv", "sequential_band", n, 1,
+                     end - start);
+
+  printf("Computing A^3 with band_multiply (Sequential)...\n");
+  perf_start(1);
+  start = get_time();
+  BandMatrix *B3 = band_multiply(B, B2, 1);
+  end = get_time();
+  perf_stop();
+  printf("A^3 computed in %f seconds.\n", end - start);
+  log_execution_time("matrix_power3.csv", "sequential_band", n, 1,
+                     end - start);
+
+  printf("Computing A^%d with band_power (Sequential)...\n", k);
+  perf_start(1);
+  start = get_time();
+  BandMatrix *Bk = band_power(B, k, 1);
+  end = get_time();
+  perf_stop();
+  printf("A^%d computed in %f seconds.\n", k, end - start);
+  char filename[64];
+  snprintf(filename, sizeof(filename), "matrix_power%d.csv", k);
+  log_execution_time(filename, "sequential_band", n, 1, end - start);
+
+  double max = band_max_abs(Bk);
+  printf("Largest entry of A^%d: %g%s\n", k, max,
+         max < BAND_EXACT_MAX ? "" : " (rounded to double)");
+
+  // A^2 and A^3 against the dedicated kernels, A^k against k - 1 products
+  check_band("band_multiply A^2", B2, band_from_penta(A2));
+  check_band("band_multiply A^3", B3, band_from_hepta(A3));
+  check_band("band_power", Bk, band_power_chain(B, k, 1));
+
   // Cleanup
-  free(A->main);
-  free(A->upper);
-  free(A->lower);
-  free(A);
+  if (file != NULL) {
+    band_file_close(file);
+  } else {
+    free(A->main);
+    free(A->upper);
+    free(A->lower);
+    free(A);
+  }
   free_penta(A2);
   free_hepta(A3);
+  free_band(B);
+  free_band(B2);
+  free_band(B3);
+  free_band(Bk);
 
   return 0;
 }
@@ -0,0 +1,98 @@
+#include "../../utils/tridiag.h"
+#include "../../utils/utils.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Compares the current SoA storage (three separate diagonals) with the
+// row-packed layout on the same matrix and vector.
+
+int main() {
+
+  init_random();
+
+  int n = 100000000;
+  int num_threads = 8;
+  int k = 8;
+
+  int *vec = random_vec_first_touch(n, num_threads);
+  TridiagMatrix *matrix =
+      random_opti_tridiagonal_matrix_first_touch(n, num_threads);
+  report_numa_placement("vec", vec, (size_t)n * sizeof(int));
+  report_numa_placement("main", matrix->main, (size_t)n * sizeof(int));
+  report_numa_placement("lower", matrix->lower, (size_t)(n - 1) * sizeof(int));
+  report_numa_placement("upper", matrix->upper, (size_t)(n - 1) * sizeof(int));
+  PackedTridiagMatrix *packed = pack_tridiagonal(matrix);
+
+  // ################################################################################
+  // y = A x
+  // ################################################################################
+
+  perf_start(num_threads);
+  double start_time = omp_get_wtime();
+  int *result_soa =
+      omp_matrix_opti_vector_multiplication(matrix, vec, n, num_threads);
+  double end_time = omp_get_wtime();
+  perf_stop();
+  printf("SoA layout A x with %d threads time: %f seconds\n", num_threads,
+         end_time - start_time);
+  log_execution_time("matrix_vector_layout.csv", "soa", n, num_threads,
+                     end_time - start_time);
+
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *result_packed =
+      omp_packed_matrix_vector_multiplication(packed, vec, n, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("Packed layout A x with %d threads time: %f seconds\n", num_threads,
+         end_time - start_time);
+  log_execution_time("matrix_vector_layout.csv", "packed", n, num_threads,
+                     end_time - start_time);
+
+  // ################################################################################
+  // y = A^k x
+  // ################################################################################
+
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *power_soa = omp_matrix_opti_power_vector_multiplication(
+      matrix, vec, n, k, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("SoA layout A^%d x with %d threads time: %f seconds\n", k,
+         num_threads, end_time - start_time);
+  log_execution_time("matrix_vector_layout.csv", "soa_power", n, num_threads,
+                     end_time - start_time);
+
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *power_packed = omp_packed_matrix_power_vector_multiplication(
+      packed, vec, n, k, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("Packed layout A^%d x with %d threads time: %f seconds\n", k,
+         num_threads, end_time - start_time);
+  log_execution_time("matrix_vector_layout.csv", "packed_power", n,
+                     num_threads, end_time - start_time);
+
+  for (int i = 0; i < n; i++) {
+    if (result_soa[i] != result_packed[i] || power_soa[i] != power_packed[i]) {
+      fprintf(stderr, "Error: layouts disagree at row %d\n", i);
+      return 1;
+    }
+  }
+
+  free(vec);
+  free(result_soa);
+  free(result_packed);
+  free(power_soa);
+  free(power_packed);
+  free(matrix->lower);
+  free(matrix->main);
+  free(matrix->upper);
+  free(matrix);
+  free_packed_tridiagonal(packed);
+
+  return 0;
+}
@@ -1,12 +1,149 @@
+#include "../../utils/tridiag.h"
+#include "../../utils/tridiag_io.h"
 #include "../../utils/utils.h"
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Usage: mpirun -np RANKS matrix_vector_mpi [local|scatter|shared]
+//                                           [blocking|overlap] [THREADS]
+//   local    (default) every rank generates its own slice of the data
+//   scatter  rank 0 generates everything and scatters it
+//   shared   like local, but the slices of the ranks of a node are one
+//            MPI_Win_allocate_shared array: on-node ghost cells are read in
+//            place, only ranks on different nodes exchange messages
+//   blocking (default) exchange the ghost cells, then compute every row
+//   overlap  post the ghost cell exchange, compute the interior rows while
+//            it is in flight and finish the two boundary rows after it
+//   THREADS  OpenMP threads per rank (default 1) running the interior rows
+//            with the kernel of matrix_vector_omp, e.g. one rank per socket
+//            or NUMA node and one thread per core (MPI_THREAD_FUNNELED:
+//            only the main thread calls MPI)
+// All modes draw from the same counter-based streams and print the same
+// checksum.
+//
+// MATVEC_FILE=path makes the local and shared modes read their slices of x
+// and of the diagonals from that binary file (see tridiag_io.h) with
+// collective MPI-IO; when it does not exist yet, the generated slices are
+// written to it. MATVEC_RESULT=path writes every rank's slice of y there.
+// I/O times go to matrix_vector_io.csv.
+
+// Slice of count ints of an array shared by the ranks of node, the slices
+// of consecutive node ranks being contiguous
+static int *shared_slice(int count, MPI_Comm node, MPI_Win *win) {
+  int *base;
+  MPI_Win_allocate_shared((MPI_Aint)count * sizeof(int), sizeof(int),
+                          MPI_INFO_NULL, node, &base, win);
+  return base;
+}
+
+// Rank of the world rank neighbour in node, MPI_UNDEFINED when it is
+// elsewhere (or does not exist)
+static int node_rank_of(int neighbour, int size, MPI_Comm node) {
+  if (neighbour < 0 || neighbour >= size)
+    return MPI_UNDEFINED;
+
+  MPI_Group world_group, node_group;
+  int node_rank;
+  MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+  MPI_Comm_group(node, &node_group);
+  MPI_Group_translate_ranks(world_group, 1, &neighbour, node_group,
+                            &node_rank);
+  MPI_Group_free(&world_group);
+  MPI_Group_free(&node_group);
+  return node_rank;
+}
+
+// Ghost cells of the shared mode: the last entry of the left neighbour and
+// the first of the right one are loaded from its slice of vec_win when it
+// is on the node, exchanged with MPI_Sendrecv otherwise
+static void shared_halo(const int *local_vec, int local_n, int rank, int size,
+                        MPI_Comm node, MPI_Win vec_win, int *ghost_left,
+                        int *ghost_right) {
+  int left = node_rank_of(rank - 1, size, node);
+  int right = node_rank_of(rank + 1, size, node);
+
+  // Make the slices written by the other node ranks visible
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, vec_win);
+  MPI_Win_sync(vec_win);
+  MPI_Barrier(node);
+  MPI_Win_sync(vec_win);
+
+  MPI_Aint bytes;
+  int unit;
+  int *slice;
+  if (left != MPI_UNDEFINED) {
+    MPI_Win_shared_query(vec_win, left, &bytes, &unit, &slice);
+    *ghost_left = slice[bytes / unit - 1];
+  } else if (rank > 0) {
+    MPI_Sendrecv(&local_vec[0], 1, MPI_INT, rank - 1, 0, ghost_left, 1,
+                 MPI_INT, rank - 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  }
+  if (right != MPI_UNDEFINED) {
+    MPI_Win_shared_query(vec_win, right, &bytes, &unit, &slice);
+    *ghost_right = slice[0];
+  } else if (rank < size - 1) {
+    MPI_Sendrecv(&local_vec[local_n - 1], 1, MPI_INT, rank + 1, 0,
+                 ghost_right, 1, MPI_INT, rank + 1, 0, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+  }
+
+  MPI_Win_unlock_all(vec_win);
+}
+
+// Row i of the local block, the ghost cells standing in for the neighbours
+static inline int row_product(int i, int local_n, int rank, int size,
+                              const int *local_lower, const int *local_main,
+                              const int *local_upper, const int *local_vec,
+                              int ghost_left, int ghost_right) {
+  long long sum = 0; // Long long to avoid overflow
+
+  // 1. Central Term
+  sum += local_main[i] * local_vec[i];
+
+  // 2. Left Term (Lower)
+  // local_lower[i] matches lower[global_i - 1]
+  if (i > 0) {
+    sum += local_lower[i] * local_vec[i - 1];
+  } else if (rank > 0) {
+    // Local block start -> use left ghost cell
+    sum += local_lower[0] * ghost_left;
+  }
+  // Note: If rank==0 and i==0, no left term
+
+  // 3. Right Term (Upper)
+  if (i < local_n - 1) {
+    sum += local_upper[i] * local_vec[i + 1];
+  } else if (rank < size - 1) {
+    // Local block end -> use right ghost cell
+    sum += local_upper[i] * ghost_right;
+  }
+  // Note: If rank==last and i==last, no right term
+
+  return (int)sum;
+}
+
+// Rows 0 and local_n - 1 (a single one when local_n == 1), once the ghost
+// cells are known
+static void boundary_rows(int local_n, int rank, int size,
+                          const int *local_lower, const int *local_main,
+                          const int *local_upper, const int *local_vec,
+                          int ghost_left, int ghost_right, int *local_result) {
+  local_result[0] = row_product(0, local_n, rank, size, local_lower, local_main,
+                                local_upper, local_vec, ghost_left, ghost_right);
+  if (local_n > 1) {
+    local_result[local_n - 1] =
+        row_product(local_n - 1, local_n, rank, size, local_lower, local_main,
+                    local_upper, local_vec, ghost_left, ghost_right);
+  }
+}
 
 // Main function
 int main(int argc, char **argv) {
 
-  MPI_Init(&argc, &argv);
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
 
   int rank, size;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -14,8 +151,22 @@ int main(int argc, char **argv) {
 
   // Global parameters
   int n = 100000000;
+  int scatter = argc > 1 && strcmp(argv[1], "scatter") == 0;
+  int shared = argc > 1 && strcmp(argv[1], "shared") == 0;
+  int overlap = argc > 2 && strcmp(argv[2], "overlap") == 0;
+  int num_threads = argc > 3 ? atoi(argv[3]) : 1;
+
+  if (num_threads < 1) {
+    if (rank == 0)
+      fprintf(stderr, "Error: need at least one thread per rank\n");
+    MPI_Finalize();
+    exit(1);
+  }
+  if (provided < MPI_THREAD_FUNNELED && rank == 0) {
+    fprintf(stderr, "Warning: MPI does not provide MPI_THREAD_FUNNELED\n");
+  }
 
-  // Rank 0 pointers (Global)
+  // Rank 0 pointers (Global, scatter mode only)
   int *vec = NULL;
   TridiagMatrix *matrix = NULL;
   int *result = NULL;
@@ -32,159 +183,311 @@ int main(int argc, char **argv) {
   int *counts = malloc(size * sizeof(int));
   int *displs = malloc(size * sizeof(int));
   int *displs_lower = malloc(size * sizeof(int));
+  int *counts_upper = malloc(size * sizeof(int));
 
   // ################################################################################
-  // 1. Initialization and Generation (Rank 0 only)
+  // 1. Load Balancing (every rank knows the whole partition)
   // ################################################################################
-  if (rank == 0) {
-    init_random();
-    vec = random_vec(n);
-    matrix = random_opti_tridiagonal_matrix(n);
-    result = malloc(n * sizeof(int));
-
-    // Load Balancing
-    int remainder = n % size;
-    int sum = 0;
-    for (int i = 0; i < size; i++) {
-      counts[i] = n / size + (i < remainder ? 1 : 0);
-      displs[i] = sum;
-
-      // Optimization Trick:
-      // To calculate row 'i', we need lower[i-1].
-      // Shift 'lower' reading by -1 for processes > 0.
-      // local_lower[0] will contain the value needed for the chunk start.
-      if (i == 0)
-        displs_lower[i] = 0;
-      else
-        displs_lower[i] = displs[i] - 1;
-
-      sum += counts[i];
-    }
+  int remainder = n % size;
+  int sum = 0;
+  for (int i = 0; i < size; i++) {
+    counts[i] = n / size + (i < remainder ? 1 : 0);
+    displs[i] = sum;
+
+    // Optimization Trick:
+    // To calculate row 'i', we need lower[i-1].
+    // Shift 'lower' reading by -1 for processes > 0.
+    // local_lower[0] will contain the value needed for the chunk start.
+    if (i == 0)
+      displs_lower[i] = 0;
+    else
+      displs_lower[i] = displs[i] - 1;
+
+    // upper has n - 1 entries: the last row has no upper term
+    counts_upper[i] = counts[i] - (i == size - 1 ? 1 : 0);
+
+    sum += counts[i];
+  }
+  local_n = counts[rank];
+
+  // Local allocation (shared mode: node-wide windows, allocated once)
+  MPI_Comm node = MPI_COMM_NULL;
+  MPI_Win wins[5];
+  if (shared) {
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank,
+                        MPI_INFO_NULL, &node);
+    local_vec = shared_slice(local_n, node, &wins[0]);
+    local_main = shared_slice(local_n, node, &wins[1]);
+    local_upper = shared_slice(local_n, node, &wins[2]);
+    local_lower = shared_slice(local_n, node, &wins[3]);
+    local_result = shared_slice(local_n, node, &wins[4]);
+  } else {
+    local_vec = malloc(local_n * sizeof(int));
+    local_main = malloc(local_n * sizeof(int));
+    local_upper = malloc(local_n * sizeof(int));
+    local_lower = malloc(local_n * sizeof(int));
+    local_result = malloc(local_n * sizeof(int));
   }
 
   // ################################################################################
-  // 2. Local size distribution
+  // 2. Initialization and Generation
   // ################################################################################
-  // Each process needs its size (local_n)
-  MPI_Scatter(counts, 1, MPI_INT, &local_n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  const char *input = scatter ? NULL : getenv("MATVEC_FILE");
+  int input_n = -1;
+  if (input != NULL && input[0] != '\0') {
+    input_n = tridiag_file_size(input, MPI_COMM_WORLD);
+    if (input_n >= 0 && input_n != n) {
+      if (rank == 0)
+        fprintf(stderr, "Error: %s holds n = %d, expected %d\n", input,
+                input_n, n);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  } else {
+    input = NULL;
+  }
 
-  // Local allocation
-  local_vec = malloc(local_n * sizeof(int));
-  local_main = malloc(local_n * sizeof(int));
-  local_upper = malloc(local_n * sizeof(int));
-  local_lower = malloc(local_n * sizeof(int));
-  local_result = malloc(local_n * sizeof(int));
+  if (input_n > 0) {
+    // Each rank reads its slice, the lower one shifted by the halo offset
+    MPI_Barrier(MPI_COMM_WORLD);
+    double io_start = MPI_Wtime();
+    tridiag_file_read(input, n, displs[rank], local_n, local_vec, local_main,
+                      local_lower, local_upper, MPI_COMM_WORLD);
+    double io_time = MPI_Wtime() - io_start;
+
+    if (rank == 0) {
+      printf("Read %s with %d processes: %f seconds (%.1f MB/s)\n", input,
+             size, io_time, (4.0 * n - 2) * sizeof(int) / io_time * 1e-6);
+      log_execution_time("matrix_vector_io.csv", "mpi_read", n, size,
+                         io_time);
+    }
+  } else if (scatter) {
+    if (rank == 0) {
+      init_random();
+      vec = random_vec(n);
+      matrix = random_opti_tridiagonal_matrix(n);
+      result = malloc(n * sizeof(int));
+    }
+  } else {
+    // Each rank fills its slice straight from the streams rank 0 would use
+    uint64_t seed = get_seed();
+    int first = displs[rank];
+
+    fill_random_vec(local_vec, local_n, first,
+                    rng_stream(seed, RNG_STREAM_VEC), 1);
+    fill_random_vec(local_main, local_n, first,
+                    rng_stream(seed, RNG_STREAM_MAIN), 1);
+    fill_random_vec(local_upper, counts_upper[rank], first,
+                    rng_stream(seed, RNG_STREAM_UPPER), 1);
+
+    // local_lower[i] is lower[first + i - 1], row 0 has no lower term
+    if (rank == 0) {
+      local_lower[0] = 0;
+      fill_random_vec(local_lower + 1, local_n - 1, 0,
+                      rng_stream(seed, RNG_STREAM_LOWER), 1);
+    } else {
+      fill_random_vec(local_lower, local_n, first - 1,
+                      rng_stream(seed, RNG_STREAM_LOWER), 1);
+    }
+
+    if (input != NULL) {
+      tridiag_file_write(input, n, first, local_n, local_vec, local_main,
+                         local_lower, local_upper, MPI_COMM_WORLD);
+    }
+  }
 
   // ################################################################################
-  // 3. Data Distribution (Scatterv)
+  // 3. Data Distribution (Scatterv, scatter mode only)
   // ################################################################################
+  perf_start(num_threads);
   double start_time = MPI_Wtime();
 
-  // Send vector X
-  MPI_Scatterv(vec, counts, displs, MPI_INT, local_vec, local_n, MPI_INT, 0,
-               MPI_COMM_WORLD);
-
-  // Send main diagonal
-  MPI_Scatterv(rank == 0 ? matrix->main : NULL, counts, displs, MPI_INT,
-               local_main, local_n, MPI_INT, 0, MPI_COMM_WORLD);
-
-  // Send upper diagonal
-  MPI_Scatterv(rank == 0 ? matrix->upper : NULL, counts, displs, MPI_INT,
-               local_upper, local_n, MPI_INT, 0, MPI_COMM_WORLD);
-
-  // Send lower diagonal (with shift)
-  MPI_Scatterv(rank == 0 ? matrix->lower : NULL, counts, displs_lower, MPI_INT,
-               local_lower, local_n, MPI_INT, 0, MPI_COMM_WORLD);
+  if (scatter) {
+    // Send vector X
+    MPI_Scatterv(vec, counts, displs, MPI_INT, local_vec, local_n, MPI_INT, 0,
+                 MPI_COMM_WORLD);
+
+    // Send main diagonal
+    MPI_Scatterv(rank == 0 ? matrix->main : NULL, counts, displs, MPI_INT,
+                 local_main, local_n, MPI_INT, 0, MPI_COMM_WORLD);
+
+    // Send upper diagonal
+    MPI_Scatterv(rank == 0 ? matrix->upper : NULL, counts_upper, displs,
+                 MPI_INT, local_upper, counts_upper[rank], MPI_INT, 0,
+                 MPI_COMM_WORLD);
+
+    // Send lower diagonal (with shift)
+    MPI_Scatterv(rank == 0 ? matrix->lower : NULL, counts, displs_lower,
+                 MPI_INT, local_lower, local_n, MPI_INT, 0, MPI_COMM_WORLD);
+
+    // Rank 0 cannot be shifted by -1: move its chunk so that local_lower[i]
+    // is lower[i-1] like on the other ranks
+    if (rank == 0) {
+      memmove(local_lower + 1, local_lower, (local_n - 1) * sizeof(int));
+      local_lower[0] = 0;
+    }
+  }
 
   // ################################################################################
-  // 4. Halo Exchange (Ghost Cells)
+  // 4. Halo Exchange (Ghost Cells) and Local Calculation
   // ################################################################################
   // Need vec[i-1] (left neighbor) and vec[i+1] (right neighbor)
+  // Formula: result[i] = lower[i-1]*vec[i-1] + main[i]*vec[i] +
+  // upper[i]*vec[i+1]
+  // Interior rows 1 .. local_n - 2 need no ghost cell and go to the OpenMP
+  // kernel; local_lower + 1 puts lower[first + i - 1] at index i - 1 like in
+  // TridiagMatrix.
 
   int ghost_left = 0;
   int ghost_right = 0;
-  MPI_Status status;
 
-  // Exchange with LEFT neighbor (Rank - 1)
-  if (rank > 0) {
-    MPI_Sendrecv(&local_vec[0], 1, MPI_INT, rank - 1, 0, &ghost_left, 1,
-                 MPI_INT, rank - 1, 0, MPI_COMM_WORLD, &status);
-  }
+  if (shared) {
+    shared_halo(local_vec, local_n, rank, size, node, wins[0], &ghost_left,
+                &ghost_right);
+
+    omp_matrix_opti_vector_rows(local_lower + 1, local_main, local_upper,
+                                local_vec, local_result, 1, local_n - 1,
+                                num_threads);
+    boundary_rows(local_n, rank, size, local_lower, local_main, local_upper,
+                  local_vec, ghost_left, ghost_right, local_result);
+  } else if (overlap) {
+    // Post the exchange with both neighbours without waiting for it
+    MPI_Request requests[4];
+    int nrequests = 0;
+    if (rank > 0) {
+      MPI_Irecv(&ghost_left, 1, MPI_INT, rank - 1, 0, MPI_COMM_WORLD,
+                &requests[nrequests++]);
+      MPI_Isend(&local_vec[0], 1, MPI_INT, rank - 1, 0, MPI_COMM_WORLD,
+                &requests[nrequests++]);
+    }
+    if (rank < size - 1) {
+      MPI_Irecv(&ghost_right, 1, MPI_INT, rank + 1, 0, MPI_COMM_WORLD,
+                &requests[nrequests++]);
+      MPI_Isend(&local_vec[local_n - 1], 1, MPI_INT, rank + 1, 0,
+                MPI_COMM_WORLD, &requests[nrequests++]);
+    }
 
-  // Exchange with RIGHT neighbor (Rank + 1)
-  if (rank < size - 1) {
-    MPI_Sendrecv(&local_vec[local_n - 1], 1, MPI_INT, rank + 1, 0, &ghost_right,
-                 1, MPI_INT, rank + 1, 0, MPI_COMM_WORLD, &status);
-  }
+    // Interior rows while the messages are in flight
+    omp_matrix_opti_vector_rows(local_lower + 1, local_main, local_upper,
+                                local_vec, local_result, 1, local_n - 1,
+                                num_threads);
 
-  // ################################################################################
-  // 5. Local Calculation
-  // ################################################################################
+    MPI_Waitall(nrequests, requests, MPI_STATUSES_IGNORE);
 
-  // Formula: result[i] = lower[i-1]*vec[i-1] + main[i]*vec[i] +
-  // upper[i]*vec[i+1]
+    boundary_rows(local_n, rank, size, local_lower, local_main, local_upper,
+                  local_vec, ghost_left, ghost_right, local_result);
+  } else {
+    MPI_Status status;
 
-  for (int i = 0; i < local_n; i++) {
-    long long sum = 0; // Long long to avoid overflow
-
-    // 1. Central Term
-    sum += local_main[i] * local_vec[i];
-
-    // 2. Left Term (Lower)
-    // local_lower[i] matches lower[global_i - 1]
-    if (i > 0) {
-      sum += local_lower[i] * local_vec[i - 1];
-    } else if (rank > 0) {
-      // Local block start -> use left ghost cell
-      sum += local_lower[0] * ghost_left;
+    // Exchange with LEFT neighbor (Rank - 1)
+    if (rank > 0) {
+      MPI_Sendrecv(&local_vec[0], 1, MPI_INT, rank - 1, 0, &ghost_left, 1,
+                   MPI_INT, rank - 1, 0, MPI_COMM_WORLD, &status);
     }
-    // Note: If rank==0 and i==0, no left term
-
-    // 3. Right Term (Upper)
-    if (i < local_n - 1) {
-      sum += local_upper[i] * local_vec[i + 1];
-    } else if (rank < size - 1) {
-      // Local block end -> use right ghost cell
-      sum += local_upper[i] * ghost_right;
+
+    // Exchange with RIGHT neighbor (Rank + 1)
+    if (rank < size - 1) {
+      MPI_Sendrecv(&local_vec[local_n - 1], 1, MPI_INT, rank + 1, 0,
+                   &ghost_right, 1, MPI_INT, rank + 1, 0, MPI_COMM_WORLD,
+                   &status);
     }
-    // Note: If rank==last and i==last, no right term
 
-    local_result[i] = (int)sum;
+    omp_matrix_opti_vector_rows(local_lower + 1, local_main, local_upper,
+                                local_vec, local_result, 1, local_n - 1,
+                                num_threads);
+    boundary_rows(local_n, rank, size, local_lower, local_main, local_upper,
+                  local_vec, ghost_left, ghost_right, local_result);
   }
 
   double end_time = MPI_Wtime();
+  perf_stop();
 
   // ################################################################################
-  // 6. Gather Results
+  // 6. Gather Results (scatter mode) and checksum
   // ################################################################################
 
-  MPI_Gatherv(local_result, local_n, MPI_INT, result, counts, displs, MPI_INT,
-              0, MPI_COMM_WORLD);
+  if (scatter) {
+    MPI_Gatherv(local_result, local_n, MPI_INT, result, counts, displs,
+                MPI_INT, 0, MPI_COMM_WORLD);
+  }
 
-  if (rank == 0) {
-    printf("MPI Matrix Vector Multiplication with %d processes. Time: %f " "seconds\n", size, end_time - start_time);
+  // The shared mode has no gather: the result of the node is already one
+  // array in wins[4]
+
+  const char *output = getenv("MATVEC_RESULT");
+  if (output != NULL && output[0] != '\0') {
+    MPI_Barrier(MPI_COMM_WORLD);
+    double io_start = MPI_Wtime();
+    vector_file_write(output, n, displs[rank], local_n, local_result,
+                      MPI_COMM_WORLD);
+    double io_time = MPI_Wtime() - io_start;
+
+    if (rank == 0) {
+      printf("Wrote y to %s with %d processes: %f seconds (%.1f MB/s)\n",
+             output, size, io_time, (double)n * sizeof(int) / io_time * 1e-6);
+      log_execution_time("matrix_vector_io.csv", "mpi_write", n, size,
+                         io_time);
+    }
+  }
 
-    log_execution_time("matrix_vector_opti.csv", "mpi", n, size, end_time - start_time);
+  // Position-weighted checksum, identical for both modes and any rank count
+  unsigned long long local_check = 0;
+  unsigned long long check = 0;
+  for (int i = 0; i < local_n; i++) {
+    local_check += (unsigned long long)(unsigned)local_result[i] *
+                   (unsigned long long)(displs[rank] + i + 1);
+  }
+  MPI_Reduce(&local_check, &check, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0,
+             MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("MPI Matrix Vector Multiplication with %d processes x %d threads "
+           "(%s generation, %s halo). Time: %f seconds\n",
+           size, num_threads, scatter ? "scatter" : (shared ? "shared" : "local"),
+           shared ? "in-place" : (overlap ? "overlapped" : "blocking"),
+           end_time - start_time);
+    printf("Checksum: %llu\n", check);
+
+    const char *methods[2][2] = {{"mpi_local", "mpi_local_overlap"},
+                                 {"mpi", "mpi_overlap"}};
+    // Hybrid runs get one method per thread count, nb_proc being the total
+    // number of cores (ranks = nb_proc / threads)
+    const char *base = shared ? "mpi_shared" : methods[scatter][overlap];
+    char method[64];
+    if (num_threads > 1)
+      snprintf(method, sizeof(method), "%s_hybrid_t%d", base, num_threads);
+    else
+      snprintf(method, sizeof(method), "%s", base);
+    log_execution_time("matrix_vector_opti.csv", method, n,
+                       size * num_threads, end_time - start_time);
 
     // Global Cleanup
-    free(vec);
-    free(result);
-    free(matrix->lower);
-    free(matrix->main);
-    free(matrix->upper);
-    free(matrix);
+    if (scatter) {
+      free(vec);
+      free(result);
+      free(matrix->lower);
+      free(matrix->main);
+      free(matrix->upper);
+      free(matrix);
+    }
   }
 
   // Local Cleanup
   free(counts);
   free(displs);
   free(displs_lower);
-  free(local_vec);
-  free(local_main);
-  free(local_upper);
-  free(local_lower);
-  free(local_result);
+  free(counts_upper);
+  if (shared) {
+    for (int k = 0; k < 5; k++)
+      MPI_Win_free(&wins[k]);
+    MPI_Comm_free(&node);
+  } else {
+    free(local_vec);
+    free(local_main);
+    free(local_upper);
+    free(local_lower);
+    free(local_result);
+  }
 
   MPI_Finalize();
   return 0;
-}
\ No newline at end of file
+}
@@ -1,52 +1,12 @@
+#include "../../utils/band_file.h"
+#include "../../utils/narrow.h"
+#include "../../utils/tridiag.h"
+#include "../../utils/tridiag_simd.h"
 #include "../../utils/utils.h"
 #include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
-
-int *omp_matrix_vector_multiplication(int **matrix, int *vec, int n,
-                                      int num_threads) {
-
-  int *result = malloc(n * sizeof(int));
-
-  omp_set_dynamic(0); // disable automatic thread allocation
-  omp_set_num_threads(num_threads);
-#pragma omp parallel for
-  for (int i = 0; i < n; i++) {
-    int sum = 0;
-    // Since it's a tridiagonal matrix, only (i-1), i, and (i+1) elements are
-    // possibly non-zero
-    if (i > 0) {
-      sum += matrix[i][i - 1] * vec[i - 1];
-    }
-    sum += matrix[i][i] * vec[i];
-    if (i < n - 1) {
-      sum += matrix[i][i + 1] * vec[i + 1];
-    }
-    result[i] = sum;
-  }
-
-  return result;
-}
-
-int *omp_matrix_opti_vector_multiplication(TridiagMatrix *matrix, int *vec,
-                                           int n, int num_threads) {
-
-  int *result = malloc(n * sizeof(int));
-
-  result[0] = matrix->main[0] * vec[0] + matrix->upper[0] * vec[1];
-  result[n - 1] =
-      matrix->lower[n - 2] * vec[n - 2] + matrix->main[n - 1] * vec[n - 1];
-
-  omp_set_dynamic(0); // disable automatic thread allocation
-  omp_set_num_threads(num_threads);
-#pragma omp parallel for
-  for (int i = 1; i < n - 1; i++) {
-    result[i] = matrix->lower[i - 1] * vec[i - 1] + matrix->main[i] * vec[i] +
-                matrix->upper[i] * vec[i + 1];
-  }
-
-  return result;
-}
+#include <string.h>
 
 int main() {
 
@@ -88,23 +48,169 @@ int main() {
 
   int n = 100000000;
 
-  int *vec = random_vec(n);
-  TridiagMatrix *matrix = random_opti_tridiagonal_matrix(n);
+  // MATRIX_FILE maps a stored A instead (see band_file.h), n is then its order
+  BandFile *file = band_file_open_input();
+  TridiagMatrix *matrix;
+  if (file != NULL) {
+    matrix = band_file_tridiagonal(file);
+    n = matrix->n;
+  } else {
+    matrix = random_opti_tridiagonal_matrix_first_touch(n, num_threads);
+    band_file_save_input(matrix);
+  }
+  int *vec = random_vec_first_touch(n, num_threads);
+  report_numa_placement("vec", vec, (size_t)n * sizeof(int));
+  report_numa_placement("main", matrix->main, (size_t)n * sizeof(int));
+  report_numa_placement("lower", matrix->lower, (size_t)(n - 1) * sizeof(int));
+  report_numa_placement("upper", matrix->upper, (size_t)(n - 1) * sizeof(int));
+  perf_start(num_threads);
   double start_time = omp_get_wtime();
   int *result =
       omp_matrix_opti_vector_multiplication(matrix, vec, n, num_threads);
   double end_time = omp_get_wtime();
+  perf_stop();
   printf(
       "OpenMP matrix vector multiplication with %d threads time: %f seconds\n",
       num_threads, end_time - start_time);
   log_execution_time("matrix_vector_opti.csv", "omp", n, num_threads, end_time - start_time);
 
+  // Same product with the explicit SIMD kernel picked at startup
+  tridiag_simd_init();
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *result_simd =
+      omp_simd_matrix_opti_vector_multiplication(matrix, vec, n, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("OpenMP SIMD (%s) matrix vector multiplication with %d threads "
+         "time: %f seconds\n", tridiag_simd_kernel(), num_threads,
+         end_time - start_time);
+  log_execution_time("matrix_vector_opti.csv", "omp_simd", n, num_threads,
+                     end_time - start_time);
+  free(result_simd);
+
+  // Same product on int8 storage, widened to int in registers. The narrow
+  // data is generated in parallel from the same streams (vec is the first
+  // vector of the program), no int copy needed.
+  int8_t *vec8 = random_vec8(n, RNG_STREAM_VEC, num_threads);
+  TridiagMatrix8 *matrix8 = random_opti_tridiagonal_matrix8(n, num_threads);
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *result8 =
+      omp_matrix8_vector_multiplication(matrix8, vec8, n, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("OpenMP int8 matrix vector multiplication with %d threads time: %f "
+         "seconds\n", num_threads, end_time - start_time);
+  log_execution_time("matrix_vector_opti.csv", "omp_int8", n, num_threads,
+                     end_time - start_time);
+
+  if (memcmp(result8, result, n * sizeof(int)) != 0) {
+    fprintf(stderr, "Error: int8 product differs from the int one\n");
+    exit(1);
+  }
+  free(vec8);
+  free(result8);
+  free_tridiagonal8(matrix8);
+
+  // Same product on int16 storage
+  int16_t *vec16 = narrow_vec16(vec, n, num_threads);
+  TridiagMatrix16 *matrix16 = narrow_tridiagonal16(matrix, num_threads);
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *result16 =
+      omp_matrix16_vector_multiplication(matrix16, vec16, n, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("OpenMP int16 matrix vector multiplication with %d threads time: %f "
+         "seconds\n", num_threads, end_time - start_time);
+  log_execution_time("matrix_vector_opti.csv", "omp_int16", n, num_threads,
+                     end_time - start_time);
+
+  if (memcmp(result16, result, n * sizeof(int)) != 0) {
+    fprintf(stderr, "Error: int16 product differs from the int one\n");
+    exit(1);
+  }
+  free(vec16);
+  free(result16);
+  free_tridiagonal16(matrix16);
+
+  // ################################################################################
+  // Repeated product A^k x
+  // ################################################################################
+
+  int k = 8;
+
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *power = vec;
+  for (int s = 0; s < k; s++) {
+    int *next = omp_matrix_opti_vector_multiplication(matrix, power, n,
+                                                       num_threads);
+    if (power != vec)
+      free(power);
+    power = next;
+  }
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("OpenMP A^%d x (k products) with %d threads time: %f seconds\n", k,
+         num_threads, end_time - start_time);
+  log_execution_time("matrix_power_vector.csv", "omp", n, num_threads,
+                     end_time - start_time);
+
+  // Same k products in one parallel region with ping-pong buffers, set up
+  // outside the timed region like the inputs of the k products
+  int *iter_x = alloc_vec_first_touch(n, num_threads);
+  int *iter_work = alloc_vec_first_touch(n, num_threads);
+  memcpy(iter_x, vec, n * sizeof(int));
+
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *power_persistent = omp_matrix_opti_vector_iterate(
+      matrix, iter_x, iter_work, n, k, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("OpenMP A^%d x (persistent region) with %d threads time: %f "
+         "seconds\n", k, num_threads, end_time - start_time);
+  log_execution_time("matrix_power_vector.csv", "omp_persistent", n,
+                     num_threads, end_time - start_time);
+
+  if (memcmp(power_persistent, power, n * sizeof(int)) != 0) {
+    fprintf(stderr, "Error: persistent A^%d x differs from k products\n", k);
+    exit(1);
+  }
+  free(iter_x);
+  free(iter_work);
+
+  perf_start(num_threads);
+  start_time = omp_get_wtime();
+  int *power_tiled = omp_matrix_opti_power_vector_multiplication(
+      matrix, vec, n, k, num_threads);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("OpenMP A^%d x (temporal blocking) with %d threads time: %f "
+         "seconds\n", k, num_threads, end_time - start_time);
+  log_execution_time("matrix_power_vector.csv", "omp_tiled", n, num_threads,
+                     end_time - start_time);
+
+  if (memcmp(power_tiled, power, n * sizeof(int)) != 0) {
+    fprintf(stderr, "Error: tiled A^%d x differs from k products\n", k);
+    exit(1);
+  }
+
+  free(power);
+  free(power_tiled);
+
   free(vec);
   free(result);
-  free(matrix->lower);
-  free(matrix->main);
-  free(matrix->upper);
-  free(matrix);
+  if (file != NULL) {
+    band_file_close(file);
+  } else {
+    free(matrix->lower);
+    free(matrix->main);
+    free(matrix->upper);
+    free(matrix);
+  }
 
   return 0;
 }
\ No newline at end of file
@@ -1,45 +1,11 @@
+#include "../../utils/band_file.h"
+#include "../../utils/tridiag.h"
+#include "../../utils/tridiag_simd.h"
 #include "../../utils/utils.h"
 #include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
-
-int *sequential_matrix_vector_multiplication(int **matrix, int *vec, int n) {
-
-  int *result = malloc(n * sizeof(int));
-
-  for (int i = 0; i < n; i++) {
-    int sum = 0;
-    // Since it's a tridiagonal matrix, only (i-1), i, and (i+1) elements are
-    // possibly non-zero
-    if (i > 0) {
-      sum += matrix[i][i - 1] * vec[i - 1];
-    }
-    sum += matrix[i][i] * vec[i];
-    if (i < n - 1) {
-      sum += matrix[i][i + 1] * vec[i + 1];
-    }
-    result[i] = sum;
-  }
-
-  return result;
-}
-
-int *sequential_matrix_opti_vector_multiplication(TridiagMatrix *matrix, int *vec, int n) {
-
-  int *result = malloc(n * sizeof(int));
-
-  result[0] = matrix->main[0] * vec[0] + matrix->upper[0] * vec[1];
-
-  for (int i = 1; i < n - 1; i++) {
-    result[i] = matrix->lower[i - 1] * vec[i - 1] + matrix->main[i] * vec[i] +
-                matrix->upper[i] * vec[i + 1];
-  }
-
-  result[n - 1] =
-      matrix->lower[n - 2] * vec[n - 2] + matrix->main[n - 1] * vec[n - 1];
-
-  return result;
-}
+#include <string.h>
 
 int main() {
 
@@ -78,23 +44,92 @@ int main() {
 
   int n = 100000000;
 
+  // MATRIX_FILE maps a stored A instead (see band_file.h), n is then its order
+  BandFile *file = band_file_open_input();
+  TridiagMatrix *matrix;
+  if (file != NULL) {
+    matrix = band_file_tridiagonal(file);
+    n = matrix->n;
+  } else {
+    matrix = random_opti_tridiagonal_matrix(n);
+    band_file_save_input(matrix);
+  }
   int *vec = random_vec(n);
-  TridiagMatrix *matrix = random_opti_tridiagonal_matrix(n);
 
+  perf_start(1);
   double start_time = omp_get_wtime();
   int *result = sequential_matrix_opti_vector_multiplication(matrix, vec, n);
   double end_time = omp_get_wtime();
+  perf_stop();
   printf("Sequential matrix vector multiplication time: %f seconds\n",
          end_time - start_time);
   log_execution_time("matrix_vector_opti.csv", "sequential", n, 1,
                      end_time - start_time);
 
+  // Same product with the explicit SIMD kernel picked at startup
+  tridiag_simd_init();
+  perf_start(1);
+  start_time = omp_get_wtime();
+  int *result_simd = simd_matrix_opti_vector_multiplication(matrix, vec, n);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("Sequential SIMD (%s) matrix vector multiplication time: %f "
+         "seconds\n", tridiag_simd_kernel(), end_time - start_time);
+  log_execution_time("matrix_vector_opti.csv", "sequential_simd", n, 1,
+                     end_time - start_time);
+  free(result_simd);
+
+  // ################################################################################
+  // Repeated product A^k x
+  // ################################################################################
+
+  int k = 8;
+
+  perf_start(1);
+  start_time = omp_get_wtime();
+  int *power = vec;
+  for (int s = 0; s < k; s++) {
+    int *next = sequential_matrix_opti_vector_multiplication(matrix, power, n);
+    if (power != vec)
+      free(power);
+    power = next;
+  }
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("Sequential A^%d x (k products) time: %f seconds\n", k,
+         end_time - start_time);
+  log_execution_time("matrix_power_vector.csv", "sequential", n, 1,
+                     end_time - start_time);
+
+  perf_start(1);
+  start_time = omp_get_wtime();
+  int *power_tiled =
+      sequential_matrix_opti_power_vector_multiplication(matrix, vec, n, k);
+  end_time = omp_get_wtime();
+  perf_stop();
+  printf("Sequential A^%d x (temporal blocking) time: %f seconds\n", k,
+         end_time - start_time);
+  log_execution_time("matrix_power_vector.csv", "sequential_tiled", n, 1,
+                     end_time - start_time);
+
+  if (memcmp(power_tiled, power, n * sizeof(int)) != 0) {
+    fprintf(stderr, "Error: tiled A^%d x differs from k products\n", k);
+    exit(1);
+  }
+
+  free(power);
+  free(power_tiled);
+
   free(vec);
   free(result);
-  free(matrix->lower);
-  free(matrix->main);
-  free(matrix->upper);
-  free(matrix);
+  if (file != NULL) {
+    band_file_close(file);
+  } else {
+    free(matrix->lower);
+    free(matrix->main);
+    free(matrix->upper);
+    free(matrix);
+  }
 
   return 0;
 }
\ No newline at end of file
@@ -5,7 +5,8 @@
  *           matrix.  Vectors use block distributions and the
  *           matrix is distributed by block rows.
  *
- * Compile:  mpicc -g -Wall -o mpi_mat_vect_mult mpi_mat_vect_mult.c
+ * Compile:  mpicc -g -Wall -fopenmp -o mpi_mat_vect_mult mpi_mat_vect_mult.c \
+ *              ../utils/utils.c ../utils/perf.c ../utils/roofline.c
  * Run:      mpiexec -n <number of processes> ./mpi_mat_vect_mult
  *
  * Input:    Dimensions of the matrix (m = number of rows, n
@@ -24,10 +25,11 @@
  *
  * IPP:      Section 3.4.9 (pp. 113 and ff.)
  */
+#include "../utils/roofline.h"
+#include "../utils/utils.h"
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 void Check_for_error(int local_ok, char fname[], char message[], MPI_Comm comm);
 void Get_dims(int *m_p, int *local_m_p, int *n_p, int *local_n_p, int my_rank,
@@ -39,10 +41,8 @@ void Read_matrix(char prompt[], double local_A[], int m, int local_m, int n,
                  int my_rank, MPI_Comm comm);
 void Read_vector(char prompt[], double local_vec[], int n, int local_n,
                  int my_rank, MPI_Comm comm);
-void Generate_matrix(double local_A[], int m, int local_m, int n, int my_rank,
-                     MPI_Comm comm);
-void Generate_vector(double local_vec[], int n, int local_n, int my_rank,
-                     MPI_Comm comm);
+void Generate_matrix(double local_A[], int local_m, int n, int my_rank);
+void Generate_vector(double local_vec[], int local_n, int my_rank);
 void Print_matrix(char title[], double local_A[], int m, int local_m, int n,
                   int my_rank, MPI_Comm comm);
 void Print_vector(char title[], double local_vec[], int n, int local_n,
@@ -50,6 +50,11 @@ void Print_vector(char title[], double local_vec[], int n, int local_n,
 void Mat_vect_mult(double local_A[], double local_x[], double local_y[],
                    int local_m, int n, int local_n, MPI_Comm comm);
 
+/* Bytes and flops per row of Mat_vect_mult: one row of A and one entry of y
+ * (the gathered x stays in cache), one multiply-add per column */
+#define MAT_VECT_BYTES(n) (8.0 * (n) + 8.0)
+#define MAT_VECT_OPS(n) (2.0 * (n))
+
 /*-------------------------------------------------------------------*/
 int main(void) {
   double *local_A;
@@ -77,26 +82,27 @@ int main(void) {
   Allocate_arrays(&local_A, &local_x, &local_y, local_m, n, local_n, comm);
 
   // Read_matrix("A", local_A, m, local_m, n, my_rank, comm);
-  srand(time(NULL) + my_rank);
-  Generate_matrix(local_A, m, local_m, n, my_rank, comm);
+  Generate_matrix(local_A, local_m, n, my_rank);
 
 #ifdef DEBUG
   Print_matrix("A", local_A, m, local_m, n, my_rank, comm);
 #endif
 
   // Read_vector("x", local_x, n, local_n, my_rank, comm);
-  Generate_vector(local_x, n, local_n, my_rank, comm);
+  Generate_vector(local_x, local_n, my_rank);
 
 #ifdef DEBUG
   Print_vector("x", local_x, n, local_n, my_rank, comm);
 #endif
 
   MPI_Barrier(comm);
+  perf_start(1);
   start = MPI_Wtime();
 
   Mat_vect_mult(local_A, local_x, local_y, local_m, n, local_n, comm);
 
   finish = MPI_Wtime();
+  perf_stop();
   loc_elapsed = finish - start;
   MPI_Reduce(&loc_elapsed, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
 
@@ -105,6 +111,10 @@ int main(void) {
     printf("Matrix size: %d x %d\n", m, n);
     printf("Processes: %d\n", comm_sz);
     printf("Elapsed time: %e seconds\n", elapsed);
+    roofline_report("Mat_vect_mult", m * MAT_VECT_BYTES(n), m * MAT_VECT_OPS(n),
+                    elapsed, comm_sz);
+    // Rank 0's counters, there is no timing file for this program
+    perf_log("mpi_mat_vect_mult.csv", "mpi", n, comm_sz);
   }
 
   // Print_vector("y", local_y, m, local_m, my_rank, comm);
@@ -318,74 +328,55 @@ void Read_vector(char prompt[] /* in  */, double local_vec[] /* out */,
 
 /*-------------------------------------------------------------------
  * Function:  Generate_matrix
- * Purpose:   Generate the tridiagonal matrix (stored densely) and distribute
+ * Purpose:   Generate the calling process' block of rows of the
+ *            tridiagonal matrix (stored densely)
+ * In args:   local_m: local number of rows of A
+ *            n:       global and local number of cols of A
+ *            my_rank: process rank
+ * Out args:  local_A: the local matrix
+ *
+ * Note:
+ *    Entries come from the counter-based streams of utils.h, so every
+ *    process builds only its own rows and A does not depend on comm_sz
  */
-void Generate_matrix(double local_A[] /* out */, int m /* in  */,
-                     int local_m /* in  */, int n /* in  */,
-                     int my_rank /* in  */, MPI_Comm comm /* in  */) {
-  double *A = NULL;
-  int local_ok = 1;
-  int i, j;
+void Generate_matrix(double local_A[] /* out */, int local_m /* in  */,
+                     int n /* in  */, int my_rank /* in  */) {
+  uint64_t seed = get_seed();
+  uint64_t lower = rng_stream(seed, RNG_STREAM_LOWER);
+  uint64_t main = rng_stream(seed, RNG_STREAM_MAIN);
+  uint64_t upper = rng_stream(seed, RNG_STREAM_UPPER);
+  int local_i, i, j;
 
-  if (my_rank == 0) {
-    A = malloc(m * n * sizeof(double));
-    if (A == NULL)
-      local_ok = 0;
-    Check_for_error(local_ok, "Generate_matrix",
-                    "Can't allocate temporary matrix", comm);
-
-    for (i = 0; i < m; i++) {
-      for (j = 0; j < n; j++) {
-        if (i == j)
-          A[i * n + j] = (rand() % 201) - 100;
-        else if (i == j - 1)
-          A[i * n + j] = (rand() % 201) - 100;
-        else if (i == j + 1)
-          A[i * n + j] = (rand() % 201) - 100;
-        else
-          A[i * n + j] = 0.0;
-      }
+  for (local_i = 0; local_i < local_m; local_i++) {
+    i = my_rank * local_m + local_i;
+    for (j = 0; j < n; j++) {
+      if (i == j)
+        local_A[local_i * n + j] = rng_range(main, i, -100, 100);
+      else if (i == j - 1)
+        local_A[local_i * n + j] = rng_range(upper, i, -100, 100);
+      else if (i == j + 1)
+        local_A[local_i * n + j] = rng_range(lower, j, -100, 100);
+      else
+        local_A[local_i * n + j] = 0.0;
     }
-    MPI_Scatter(A, local_m * n, MPI_DOUBLE, local_A, local_m * n, MPI_DOUBLE, 0,
-                comm);
-    free(A);
-  } else {
-    Check_for_error(local_ok, "Generate_matrix",
-                    "Can't allocate temporary matrix", comm);
-    MPI_Scatter(A, local_m * n, MPI_DOUBLE, local_A, local_m * n, MPI_DOUBLE, 0,
-                comm);
   }
 } /* Generate_matrix */
 
 /*-------------------------------------------------------------------
  * Function:  Generate_vector
- * Purpose:   Generate random vector and distribute
+ * Purpose:   Generate the calling process' block of a random vector
+ * In args:   local_n:   local order of vector (n/comm_sz)
+ *            my_rank:   process rank
+ * Out args:  local_vec: the local vector
  */
-void Generate_vector(double local_vec[] /* out */, int n /* in  */,
-                     int local_n /* in  */, int my_rank /* in  */,
-                     MPI_Comm comm /* in  */) {
-  double *vec = NULL;
-  int i, local_ok = 1;
-
-  if (my_rank == 0) {
-    vec = malloc(n * sizeof(double));
-    if (vec == NULL)
-      local_ok = 0;
-    Check_for_error(local_ok, "Generate_vector",
-                    "Can't allocate temporary vector", comm);
-
-    for (i = 0; i < n; i++)
-      vec[i] = (rand() % 201) - 100;
-
-    MPI_Scatter(vec, local_n, MPI_DOUBLE, local_vec, local_n, MPI_DOUBLE, 0,
-                comm);
-    free(vec);
-  } else {
-    Check_for_error(local_ok, "Generate_vector",
-                    "Can't allocate temporary vector", comm);
-    MPI_Scatter(vec, local_n, MPI_DOUBLE, local_vec, local_n, MPI_DOUBLE, 0,
-                comm);
-  }
+void Generate_vector(double local_vec[] /* out */, int local_n /* in  */,
+                     int my_rank /* in  */) {
+  uint64_t stream = rng_stream(get_seed(), RNG_STREAM_VEC);
+  int i;
+
+  for (i = 0; i < local_n; i++)
+    local_vec[i] = rng_range(stream, (long long)my_rank * local_n + i, -100,
+                             100);
 } /* Generate_vector */
 
 /*-------------------------------------------------------------------
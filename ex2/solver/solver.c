@@ -0,0 +1,88 @@
+#include "../../utils/solver.h"
+#include "../../utils/utils.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Usage: solver [N] [THREADS]
+// Solves A x = b for the random SPD tridiagonal matrix with CG, Jacobi and
+// red-black Gauss-Seidel, on one thread and on THREADS threads, from x = 0,
+// then directly with the Thomas algorithm and with SPIKE on THREADS threads.
+
+typedef SolverStats (*solver_fn)(TridiagMatrix *A, const double *b,
+                                 double *x, int n, double tol, int max_iter,
+                                 int num_threads);
+
+int main(int argc, char **argv) {
+  init_random();
+
+  int n = argc > 1 ? atoi(argv[1]) : 10000000; // 10 Million
+  int num_threads = argc > 2 ? atoi(argv[2]) : 8;
+  double tol = 1e-8;
+  int max_iter = 10000;
+
+  if (n <= 1 || num_threads < 1) {
+    fprintf(stderr, "Error: Usage: %s [N] [THREADS]\n", argv[0]);
+    exit(1);
+  }
+
+  const char *names[] = {"cg", "jacobi", "gauss_seidel"};
+  const solver_fn solvers[] = {cg_solve, jacobi_solve, gauss_seidel_solve};
+
+  printf("Generating SPD Tridiagonal Matrix of size %d...\n", n);
+  TridiagMatrix *A = random_spd_tridiagonal_matrix(n);
+  double *b = malloc(n * sizeof(double));
+  double *x = malloc(n * sizeof(double));
+  fill_rhs(b, n, 0);
+
+  for (int s = 0; s < 3; s++) {
+    for (int parallel = 0; parallel < 2; parallel++) {
+      int threads = parallel ? num_threads : 1;
+      char method[64];
+      snprintf(method, sizeof(method), "%s_%s", names[s],
+               parallel ? "omp" : "sequential");
+
+      memset(x, 0, n * sizeof(double));
+
+      perf_start(threads);
+      double start = omp_get_wtime();
+      SolverStats stats = solvers[s](A, b, x, n, tol, max_iter, threads);
+      double end = omp_get_wtime();
+      perf_stop();
+
+      printf("%s with %d threads: %d iterations, residual %.3e (recomputed "
+             "%.3e), time %f seconds\n",
+             method, threads, stats.iterations, stats.residual,
+             tridiag_residual_norm(A, b, x, n, threads), end - start);
+      log_execution_time("solver.csv", method, n, threads, end - start);
+    }
+  }
+
+  for (int parallel = 0; parallel < 2; parallel++) {
+    int threads = parallel ? num_threads : 1;
+    const char *method = parallel ? "spike_omp" : "thomas_sequential";
+
+    perf_start(threads);
+    double start = omp_get_wtime();
+    if (parallel)
+      spike_solve(A, b, x, n, threads);
+    else
+      thomas_solve(A, b, x, n);
+    double end = omp_get_wtime();
+    perf_stop();
+
+    printf("%s with %d threads: residual %.3e, time %f seconds\n", method,
+           threads, tridiag_residual_norm(A, b, x, n, threads), end - start);
+    log_execution_time("solver.csv", method, n, threads, end - start);
+  }
+
+  free(b);
+  free(x);
+  free(A->lower);
+  free(A->main);
+  free(A->upper);
+  free(A);
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include "../../utils/solver_mpi.h"
+#include "../../utils/utils.h"
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Usage: mpirun -np P solver_mpi [N]
+// Distributed CG, Jacobi and red-black Gauss-Seidel on the random SPD
+// tridiagonal matrix, every rank generating and keeping its own rows, then
+// the direct SPIKE solve with one block per rank.
+
+typedef SolverStats (*mpi_solver_fn)(DistTridiagMatrix *A, const double *b,
+                                     double *x, double tol, int max_iter);
+
+int main(int argc, char **argv) {
+
+  MPI_Init(&argc, &argv);
+
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  int n = argc > 1 ? atoi(argv[1]) : 10000000; // 10 Million
+  double tol = 1e-8;
+  int max_iter = 10000;
+
+  const char *names[] = {"cg_mpi", "jacobi_mpi", "gauss_seidel_mpi"};
+  const mpi_solver_fn solvers[] = {mpi_cg_solve, mpi_jacobi_solve,
+                                   mpi_gauss_seidel_solve};
+
+  DistTridiagMatrix *A = random_spd_tridiagonal_dist(n, MPI_COMM_WORLD);
+  double *b = malloc(A->local_n * sizeof(double));
+  double *x = malloc(A->local_n * sizeof(double));
+  fill_rhs(b, A->local_n, A->first);
+
+  for (int s = 0; s < 3; s++) {
+    memset(x, 0, A->local_n * sizeof(double));
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    perf_start(1);
+    double start = MPI_Wtime();
+    SolverStats stats = solvers[s](A, b, x, tol, max_iter);
+    double end = MPI_Wtime();
+    perf_stop();
+
+    double check = mpi_residual_norm(A, b, x);
+    if (rank == 0) {
+      printf("%s with %d processes: %d iterations, residual %.3e "
+             "(recomputed %.3e), time %f seconds\n",
+             names[s], size, stats.iterations, stats.residual, check,
+             end - start);
+      log_execution_time("solver.csv", names[s], n, size, end - start);
+    }
+  }
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  perf_start(1);
+  double start = MPI_Wtime();
+  mpi_spike_solve(A, b, x);
+  double end = MPI_Wtime();
+  perf_stop();
+
+  double check = mpi_residual_norm(A, b, x);
+  if (rank == 0) {
+    printf("spike_mpi with %d processes: residual %.3e, time %f seconds\n",
+           size, check, end - start);
+    log_execution_time("solver.csv", "spike_mpi", n, size, end - start);
+  }
+
+  free(b);
+  free(x);
+  free_dist_tridiagonal(A);
+
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,307 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "band.h"
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BAND_ALIGN 64
+#define BAND_BLOCK 4096 // rows per work item, the accumulator stays in L1/L2
+
+BandMatrix *band_alloc(int n, int kl, int ku) {
+
+  if (n <= 1) {
+    fprintf(stderr, "Error : n must be greater than 1\n");
+    exit(1);
+  }
+
+  if (kl < 0 || ku < 0 || kl > n - 1 || ku > n - 1) {
+    fprintf(stderr, "Error: invalid bandwidth (kl=%d, ku=%d) for n=%d\n", kl,
+            ku, n);
+    exit(1);
+  }
+
+  BandMatrix *m = malloc(sizeof(BandMatrix));
+  if (m == NULL) {
+    fprintf(stderr, "Error: Could not allocate band matrix\n");
+    exit(1);
+  }
+
+  size_t per_line = BAND_ALIGN / sizeof(double);
+  m->n = n;
+  m->kl = kl;
+  m->ku = ku;
+  m->ld = ((size_t)n + per_line - 1) / per_line * per_line;
+
+  void *data = NULL;
+  size_t ndiag = (size_t)(kl + ku + 1);
+  if (posix_memalign(&data, BAND_ALIGN, ndiag * m->ld * sizeof(double)) != 0) {
+    fprintf(stderr, "Error: Could not allocate band matrix of size %d\n", n);
+    exit(1);
+  }
+  m->data = data;
+
+  // Only the padding is cleared here, the diagonals are filled by the caller
+  for (size_t d = 0; d < ndiag; d++) {
+    memset(m->data + d * m->ld + n, 0, (m->ld - n) * sizeof(double));
+  }
+
+  return m;
+}
+
+void free_band(BandMatrix *m) {
+  if (!m)
+    return;
+  free(m->data);
+  free(m);
+}
+
+BandMatrix *band_identity(int n) {
+  BandMatrix *m = band_alloc(n, 0, 0);
+  for (int i = 0; i < n; i++)
+    m->data[i] = 1;
+  return m;
+}
+
+BandMatrix *band_copy(const BandMatrix *m) {
+  BandMatrix *c = band_alloc(m->n, m->kl, m->ku);
+  memcpy(c->data, m->data,
+         (size_t)(m->kl + m->ku + 1) * m->ld * sizeof(double));
+  return c;
+}
+
+// Diagonal d from the n - |d| entries of the structs of utils.h: entry i of a
+// sub diagonal is A_{i+|d|, i}, which is slot i + |d| of the band storage
+static void set_diag(BandMatrix *m, int d, const int *v) {
+  int n = m->n;
+  int off = d < 0 ? -d : 0;
+  int len = n - (d < 0 ? -d : d);
+  double *diag = BAND_DIAG(m, d);
+
+  for (int i = 0; i < n; i++)
+    diag[i] = 0;
+  for (int i = 0; i < len; i++)
+    diag[i + off] = v[i];
+}
+
+BandMatrix *band_from_tridiagonal(const TridiagMatrix *A) {
+  BandMatrix *m = band_alloc(A->n, 1, 1);
+  set_diag(m, -1, A->lower);
+  set_diag(m, 0, A->main);
+  set_diag(m, 1, A->upper);
+  return m;
+}
+
+BandMatrix *band_from_penta(const PentaDiagMatrix *A2) {
+  BandMatrix *m = band_alloc(A2->n, 2, 2);
+  set_diag(m, -2, A2->lower2);
+  set_diag(m, -1, A2->lower1);
+  set_diag(m, 0, A2->main);
+  set_diag(m, 1, A2->upper1);
+  set_diag(m, 2, A2->upper2);
+  return m;
+}
+
+BandMatrix *band_from_hepta(const HeptaDiagMatrix *A3) {
+  BandMatrix *m = band_alloc(A3->n, 3, 3);
+  set_diag(m, -3, A3->lower3);
+  set_diag(m, -2, A3->lower2);
+  set_diag(m, -1, A3->lower1);
+  set_diag(m, 0, A3->main);
+  set_diag(m, 1, A3->upper1);
+  set_diag(m, 2, A3->upper2);
+  set_diag(m, 3, A3->upper3);
+  return m;
+}
+
+double band_get(const BandMatrix *m, int i, int j) {
+  int d = j - i;
+  if (i < 0 || i >= m->n || j < 0 || j >= m->n || d < -m->kl || d > m->ku)
+    return 0;
+  return BAND_DIAG(m, d)[i];
+}
+
+double band_max_abs(const BandMatrix *m) {
+  size_t count = (size_t)(m->kl + m->ku + 1) * m->ld;
+  double max = 0;
+  for (size_t i = 0; i < count; i++) {
+    double v = fabs(m->data[i]);
+    if (v > max)
+      max = v;
+  }
+  return max;
+}
+
+double band_max_diff(const BandMatrix *A, const BandMatrix *B) {
+  if (A->n != B->n || A->kl != B->kl || A->ku != B->ku) {
+    fprintf(stderr, "Error: band_max_diff shape mismatch\n");
+    exit(1);
+  }
+
+  size_t count = (size_t)(A->kl + A->ku + 1) * A->ld;
+  double max = 0;
+  for (size_t i = 0; i < count; i++) {
+    double v = fabs(A->data[i] - B->data[i]);
+    if (v > max)
+      max = v;
+  }
+  return max;
+}
+
+// C = A * B
+// C_{i, i+d} = sum_k A_{i, k} B_{k, i+d} with k = i + da, so
+// C_d[i] = sum_da A_da[i] * B_{d-da}[i+da].
+// Slots outside the matrix are 0 in A and B, so only k has to be bounds
+// checked: the product then stays 0 outside the matrix as well.
+BandMatrix *band_multiply(const BandMatrix *A, const BandMatrix *B,
+                          int num_threads) {
+
+  if (A->n != B->n) {
+    fprintf(stderr, "Error: band_multiply size mismatch (%d vs %d)\n", A->n,
+            B->n);
+    exit(1);
+  }
+
+  int n = A->n;
+  int kl = A->kl + B->kl < n - 1 ? A->kl + B->kl : n - 1;
+  int ku = A->ku + B->ku < n - 1 ? A->ku + B->ku : n - 1;
+  BandMatrix *C = band_alloc(n, kl, ku);
+
+  int nblocks = (n + BAND_BLOCK - 1) / BAND_BLOCK;
+
+  omp_set_dynamic(0);
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(static)
+  for (int b = 0; b < nblocks; b++) {
+    double acc[BAND_BLOCK];
+    int lo = b * BAND_BLOCK;
+    int hi = lo + BAND_BLOCK < n ? lo + BAND_BLOCK : n;
+
+    for (int d = -kl; d <= ku; d++) {
+      int da_min = d - B->ku > -A->kl ? d - B->ku : -A->kl;
+      int da_max = d + B->kl < A->ku ? d + B->kl : A->ku;
+
+      for (int i = 0; i < hi - lo; i++)
+        acc[i] = 0;
+
+      for (int da = da_min; da <= da_max; da++) {
+        const double *a = BAND_DIAG(A, da);
+        const double *bd = BAND_DIAG(B, d - da);
+        int start = lo > -da ? lo : -da;
+        int end = hi < n - da ? hi : n - da;
+        for (int i = start; i < end; i++) {
+          acc[i - lo] += a[i] * bd[i + da];
+        }
+      }
+
+      double *c = BAND_DIAG(C, d);
+      for (int i = lo; i < hi; i++)
+        c[i] = acc[i - lo];
+    }
+  }
+
+  return C;
+}
+
+// A^k by repeated squaring: O(log k) band products instead of k - 1.
+// The bandwidth of the result grows to k * kl below and k * ku above the
+// diagonal (2k + 1 diagonals for a tridiagonal A), capped at n - 1.
+BandMatrix *band_power(const BandMatrix *A, int k, int num_threads) {
+
+  if (k < 0) {
+    fprintf(stderr, "Error: k must be non-negative\n");
+    exit(1);
+  }
+
+  if (k == 0)
+    return band_identity(A->n);
+
+  const BandMatrix *base = A; // A^(2^j)
+  BandMatrix *owned = NULL;   // base when it is not A
+  BandMatrix *result = NULL;
+
+  while (1) {
+    if (k & 1) {
+      if (result == NULL) {
+        result = band_copy(base);
+      } else {
+        BandMatrix *tmp = band_multiply(result, base, num_threads);
+        free_band(result);
+        result = tmp;
+      }
+    }
+
+    k >>= 1;
+    if (k == 0)
+      break;
+
+    BandMatrix *sq = band_multiply(base, base, num_threads);
+    free_band(owned);
+    owned = sq;
+    base = sq;
+  }
+
+  free_band(owned);
+  return result;
+}
+
+BandMatrix *band_power_chain(const BandMatrix *A, int k, int num_threads) {
+
+  if (k < 1) {
+    fprintf(stderr, "Error: k must be positive\n");
+    exit(1);
+  }
+
+  BandMatrix *result = band_copy(A);
+  for (int j = 1; j < k; j++) {
+    BandMatrix *tmp = band_multiply(result, A, num_threads);
+    free_band(result);
+    result = tmp;
+  }
+  return result;
+}
+
+// Adds the cost of one band_multiply to bytes and ops, returns the bandwidth
+// of the product in *ckl / *cku
+static void band_multiply_cost(int akl, int aku, int bkl, int bku, int *ckl,
+                               int *cku, double *bytes, double *ops) {
+  *ckl = akl + bkl;
+  *cku = aku + bku;
+  *bytes += 8.0 * ((akl + aku + 1) + (bkl + bku + 1) + (*ckl + *cku + 1));
+
+  // Same loop bounds as band_multiply, one multiply-add per term
+  for (int d = -*ckl; d <= *cku; d++) {
+    int da_min = d - bku > -akl ? d - bku : -akl;
+    int da_max = d + bkl < aku ? d + bkl : aku;
+    *ops += 2.0 * (da_max - da_min + 1);
+  }
+}
+
+void band_power_cost(const BandMatrix *A, int k, double *bytes, double *ops) {
+  int base_kl = A->kl, base_ku = A->ku;
+  int res_kl = -1, res_ku = -1; // no result yet
+  *bytes = 0;
+  *ops = 0;
+
+  // Replays the squarings and products of band_power
+  while (k > 0) {
+    if (k & 1) {
+      if (res_kl < 0) {
+        res_kl = base_kl;
+        res_ku = base_ku;
+      } else {
+        band_multiply_cost(res_kl, res_ku, base_kl, base_ku, &res_kl, &res_ku,
+                           bytes, ops);
+      }
+    }
+
+    k >>= 1;
+    if (k == 0)
+      break;
+
+    band_multiply_cost(base_kl, base_ku, base_kl, base_ku, &base_kl, &base_ku,
+                       bytes, ops);
+  }
+}
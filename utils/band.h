@@ -0,0 +1,66 @@
+#ifndef BAND_H
+#define BAND_H
+
+#include "utils.h"
+#include <stddef.h>
+
+// Band matrix with kl sub diagonals and ku super diagonals.
+// All diagonals live in one 64-byte aligned block, diagonal d (-kl <= d <= ku)
+// starting at data + (kl + d) * ld. Entry i of diagonal d is A_{i, i+d}, so
+// every diagonal has n slots and the slots whose column falls outside the
+// matrix are kept at 0.
+//
+// Entries are doubles so that high powers do not overflow: the entries of A^k
+// grow like |A|^k (about 1e10 for A^8 and 1e40 for A^32 with the inputs of
+// utils.h). Products of integer matrices are exact as long as every partial
+// sum stays below BAND_EXACT_MAX in magnitude, and rounded to double precision
+// beyond, instead of wrapping around like int or int64 storage would.
+#define BAND_EXACT_MAX 9007199254740992.0 // 2^53
+
+typedef struct {
+  int n;
+  int kl;    // number of sub diagonals
+  int ku;    // number of super diagonals
+  size_t ld;    // stride between diagonals (n rounded up to a 64-byte multiple)
+  double *data; // (kl + ku + 1) * ld entries
+} BandMatrix;
+
+// Pointer to diagonal d (d < 0: below main, d > 0: above main)
+#define BAND_DIAG(m, d) ((m)->data + (size_t)((m)->kl + (d)) * (m)->ld)
+
+BandMatrix *band_alloc(int n, int kl, int ku);
+
+void free_band(BandMatrix *m);
+
+BandMatrix *band_identity(int n);
+
+BandMatrix *band_copy(const BandMatrix *m);
+
+BandMatrix *band_from_tridiagonal(const TridiagMatrix *A);
+
+BandMatrix *band_from_penta(const PentaDiagMatrix *A2);
+
+BandMatrix *band_from_hepta(const HeptaDiagMatrix *A3);
+
+double band_get(const BandMatrix *m, int i, int j);
+
+// Largest |entry| of m
+double band_max_abs(const BandMatrix *m);
+
+// Largest |A_ij - B_ij|, A and B having the same size and bandwidths
+double band_max_diff(const BandMatrix *A, const BandMatrix *B);
+
+BandMatrix *band_multiply(const BandMatrix *A, const BandMatrix *B,
+                          int num_threads);
+
+BandMatrix *band_power(const BandMatrix *A, int k, int num_threads);
+
+// A^k as k - 1 successive products A * A * ... * A, the reference band_power
+// is checked against (k >= 1)
+BandMatrix *band_power_chain(const BandMatrix *A, int k, int num_threads);
+
+// Compulsory bytes and flops per row of band_power(A, k), summed over
+// the products it performs (every diagonal read or written once per product)
+void band_power_cost(const BandMatrix *A, int k, double *bytes, double *ops);
+
+#endif
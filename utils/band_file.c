@@ -0,0 +1,267 @@
+#define _GNU_SOURCE
+
+#include "band_file.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BAND_FILE_MAGIC "HPCBAND"
+#define BAND_FILE_ALIGN 64
+
+_Static_assert(sizeof(BandFileHeader) == BAND_FILE_ALIGN,
+               "the sections must start 64-byte aligned");
+
+static uint64_t section_stride(int n) {
+  uint64_t bytes = (uint64_t)n * sizeof(int);
+  return (bytes + BAND_FILE_ALIGN - 1) / BAND_FILE_ALIGN * BAND_FILE_ALIGN;
+}
+
+// Sum of v[i] * (base + i + 1), base being the position of the section in
+// ints: swapped or shifted entries change it
+static uint64_t section_checksum(const int *v, long long count, uint64_t base) {
+  uint64_t sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+  for (long long i = 0; i < count; i++)
+    sum += (uint64_t)(uint32_t)v[i] * (base + (uint64_t)i + 1);
+  return sum;
+}
+
+static long long diag_length(int n, int d) { return n - (d < 0 ? -d : d); }
+
+// ################################################################################
+// Write
+// ################################################################################
+
+// diags[kl + d] is diagonal d, for d = -kl .. ku
+static void write_band_file(const char *path, int n, int kl, int ku,
+                            int *const *diags, uint64_t seed) {
+  BandFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, BAND_FILE_MAGIC, sizeof(BAND_FILE_MAGIC));
+  h.version = BAND_FILE_VERSION;
+  h.type = BAND_FILE_INT32;
+  h.n = n;
+  h.kl = kl;
+  h.ku = ku;
+  h.seed = seed;
+  h.stride = section_stride(n);
+
+  for (int s = 0; s < kl + ku + 1; s++) {
+    h.checksum += section_checksum(diags[s], diag_length(n, s - kl),
+                                   s * (h.stride / sizeof(int)));
+  }
+
+  size_t len = strlen(path) + 8;
+  char *tmp = malloc(len);
+  snprintf(tmp, len, "%s.tmp", path);
+
+  FILE *file = fopen(tmp, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open file %s for writing\n", tmp);
+    exit(1);
+  }
+
+  static const char zeros[BAND_FILE_ALIGN];
+  int ok = fwrite(&h, sizeof(h), 1, file) == 1;
+  for (int s = 0; s < kl + ku + 1 && ok; s++) {
+    size_t count = diag_length(n, s - kl);
+    ok = fwrite(diags[s], sizeof(int), count, file) == count;
+
+    size_t pad = h.stride - count * sizeof(int);
+    while (ok && pad > 0) {
+      size_t chunk = pad < sizeof(zeros) ? pad : sizeof(zeros);
+      ok = fwrite(zeros, 1, chunk, file) == chunk;
+      pad -= chunk;
+    }
+  }
+
+  if (fclose(file) != 0 || !ok || rename(tmp, path) != 0) {
+    fprintf(stderr, "Error: Could not write band file %s\n", path);
+    exit(1);
+  }
+  free(tmp);
+}
+
+void band_file_write_tridiagonal(const char *path, const TridiagMatrix *A,
+                                 uint64_t seed) {
+  int *const diags[3] = {A->lower, A->main, A->upper};
+  write_band_file(path, A->n, 1, 1, diags, seed);
+}
+
+void band_file_write_penta(const char *path, const PentaDiagMatrix *A2,
+                           uint64_t seed) {
+  int *const diags[5] = {A2->lower2, A2->lower1, A2->main, A2->upper1,
+                         A2->upper2};
+  write_band_file(path, A2->n, 2, 2, diags, seed);
+}
+
+void band_file_write_hepta(const char *path, const HeptaDiagMatrix *A3,
+                           uint64_t seed) {
+  int *const diags[7] = {A3->lower3, A3->lower2, A3->lower1, A3->main,
+                         A3->upper1, A3->upper2, A3->upper3};
+  write_band_file(path, A3->n, 3, 3, diags, seed);
+}
+
+// ################################################################################
+// Load
+// ################################################################################
+
+static int *section(const BandFile *f, int d) {
+  return (int *)((char *)f->map + sizeof(BandFileHeader) +
+                 (size_t)(f->header.kl + d) * f->header.stride);
+}
+
+uint64_t band_file_checksum(const BandFile *f) {
+  const BandFileHeader *h = &f->header;
+  uint64_t sum = 0;
+  for (int d = -h->kl; d <= h->ku; d++) {
+    sum += section_checksum(section(f, d), diag_length((int)h->n, d),
+                            (h->kl + d) * (h->stride / sizeof(int)));
+  }
+  return sum;
+}
+
+static void malformed(const char *path, const char *why) {
+  fprintf(stderr, "Error: %s is not a usable band file (%s)\n", path, why);
+  exit(1);
+}
+
+BandFile *band_file_open(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BandFileHeader))
+    malformed(path, "too short");
+
+  // Private mapping: the data is shared with the page cache until a kernel
+  // writes to it, which then only touches this process's copy
+  void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                   0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Error: Could not map file %s\n", path);
+    exit(1);
+  }
+
+  BandFile *f = malloc(sizeof(BandFile));
+  f->map = map;
+  f->size = st.st_size;
+  memcpy(&f->header, map, sizeof(BandFileHeader));
+
+  const BandFileHeader *h = &f->header;
+  if (memcmp(h->magic, BAND_FILE_MAGIC, sizeof(BAND_FILE_MAGIC)) != 0)
+    malformed(path, "bad magic");
+  if (h->version != BAND_FILE_VERSION || h->type != BAND_FILE_INT32)
+    malformed(path, "unsupported version or element type");
+  if (h->n < 2 || h->n > INT32_MAX || h->kl < 0 || h->ku < 0 ||
+      h->kl >= h->n || h->ku >= h->n || h->stride % BAND_FILE_ALIGN != 0 ||
+      h->stride < (uint64_t)h->n * sizeof(int))
+    malformed(path, "bad dimensions");
+  if (f->size < sizeof(BandFileHeader) + (h->kl + h->ku + 1) * h->stride)
+    malformed(path, "truncated");
+
+  const char *verify = getenv("BAND_FILE_VERIFY");
+  if (verify != NULL && verify[0] != '\0' &&
+      band_file_checksum(f) != h->checksum)
+    malformed(path, "checksum mismatch");
+
+  return f;
+}
+
+static void check_band(const BandFile *f, int kl, int ku) {
+  if (f->header.kl != kl || f->header.ku != ku) {
+    fprintf(stderr,
+            "Error: band file holds %d sub and %d super diagonals, expected "
+            "%d and %d\n",
+            f->header.kl, f->header.ku, kl, ku);
+    exit(1);
+  }
+}
+
+TridiagMatrix *band_file_tridiagonal(BandFile *f) {
+  check_band(f, 1, 1);
+  TridiagMatrix *A = &f->view.tri;
+  A->n = (int)f->header.n;
+  A->lower = section(f, -1);
+  A->main = section(f, 0);
+  A->upper = section(f, 1);
+  return A;
+}
+
+PentaDiagMatrix *band_file_penta(BandFile *f) {
+  check_band(f, 2, 2);
+  PentaDiagMatrix *A = &f->view.penta;
+  A->n = (int)f->header.n;
+  A->lower2 = section(f, -2);
+  A->lower1 = section(f, -1);
+  A->main = section(f, 0);
+  A->upper1 = section(f, 1);
+  A->upper2 = section(f, 2);
+  return A;
+}
+
+HeptaDiagMatrix *band_file_hepta(BandFile *f) {
+  check_band(f, 3, 3);
+  HeptaDiagMatrix *A = &f->view.hepta;
+  A->n = (int)f->header.n;
+  A->lower3 = section(f, -3);
+  A->lower2 = section(f, -2);
+  A->lower1 = section(f, -1);
+  A->main = section(f, 0);
+  A->upper1 = section(f, 1);
+  A->upper2 = section(f, 2);
+  A->upper3 = section(f, 3);
+  return A;
+}
+
+void band_file_close(BandFile *f) {
+  if (!f)
+    return;
+  munmap(f->map, f->size);
+  free(f);
+}
+
+// ################################################################################
+// Driver inputs
+// ################################################################################
+
+static const char *input_path(void) {
+  const char *path = getenv("MATRIX_FILE");
+  return path != NULL && path[0] != '\0' ? path : NULL;
+}
+
+BandFile *band_file_open_input(void) {
+  const char *path = input_path();
+  if (path == NULL)
+    return NULL;
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  BandFile *f = band_file_open(path);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (f == NULL)
+    return NULL;
+
+  check_band(f, 1, 1);
+  printf("Mapped Tridiagonal Matrix of size %lld from %s in %f ms\n",
+         (long long)f->header.n, path,
+         (end.tv_sec - start.tv_sec) * 1e3 +
+             (end.tv_nsec - start.tv_nsec) * 1e-6);
+  if (f->header.seed != get_seed())
+    fprintf(stderr, "Warning: %s was generated with seed %llu\n", path,
+            (unsigned long long)f->header.seed);
+  return f;
+}
+
+void band_file_save_input(const TridiagMatrix *A) {
+  const char *path = input_path();
+  if (path != NULL)
+    band_file_write_tridiagonal(path, A, get_seed());
+}
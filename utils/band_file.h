@@ -0,0 +1,84 @@
+#ifndef BAND_FILE_H
+#define BAND_FILE_H
+
+#include "utils.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary file of a band matrix (tridiagonal, A^2 or A^3), meant to be
+// generated once and mmap'ed by every later run:
+//
+//   header     BandFileHeader, 64 bytes
+//   section d  diagonal d for d = -kl .. ku, at 64 + (kl + d) * stride bytes
+//
+// Every section is 64-byte aligned and holds the n - |d| entries of the
+// diagonal in the order of the structs of utils.h (entry i is A_{i+|d|,i}
+// below the main diagonal, A_{i,i+d} above it), zero padded up to stride.
+// The loader hands out pointers straight into the mapping.
+
+#define BAND_FILE_VERSION 1
+#define BAND_FILE_INT32 1 // element type, the only one written so far
+
+typedef struct {
+  char magic[8];     // "HPCBAND"
+  uint32_t version;  // BAND_FILE_VERSION
+  uint32_t type;     // BAND_FILE_INT32
+  int64_t n;         // order of the matrix
+  int32_t kl;        // sub diagonals
+  int32_t ku;        // super diagonals
+  uint64_t seed;     // HPC_SEED the input was generated with
+  uint64_t checksum; // band_file_checksum of the sections
+  uint64_t stride;   // bytes between two sections, a multiple of 64
+  uint8_t reserved[8];
+} BandFileHeader;
+
+typedef struct {
+  BandFileHeader header;
+  void *map;   // private, copy-on-write mapping of the whole file
+  size_t size; // bytes mapped
+  union {
+    TridiagMatrix tri;
+    PentaDiagMatrix penta;
+    HeptaDiagMatrix hepta;
+  } view;
+} BandFile;
+
+// Maps path, NULL when it does not exist. Exits on a malformed file. The
+// checksum is only verified when the BAND_FILE_VERIFY environment variable
+// is set, so opening costs no pass over the data.
+BandFile *band_file_open(const char *path);
+
+// Matrices pointing into the mapping (no copy), owned by f: valid until
+// band_file_close and never to be freed. Exit when the bandwidths differ.
+TridiagMatrix *band_file_tridiagonal(BandFile *f);
+
+PentaDiagMatrix *band_file_penta(BandFile *f);
+
+HeptaDiagMatrix *band_file_hepta(BandFile *f);
+
+// Position-weighted sum of all the sections, as stored in the header
+uint64_t band_file_checksum(const BandFile *f);
+
+void band_file_close(BandFile *f);
+
+// Writers: the file is written to a temporary name and renamed into place.
+// seed is recorded in the header (get_seed() for generated inputs).
+void band_file_write_tridiagonal(const char *path, const TridiagMatrix *A,
+                                 uint64_t seed);
+
+void band_file_write_penta(const char *path, const PentaDiagMatrix *A2,
+                           uint64_t seed);
+
+void band_file_write_hepta(const char *path, const HeptaDiagMatrix *A3,
+                           uint64_t seed);
+
+// Inputs of the drivers: MATRIX_FILE=path names the band file A is mapped
+// from, so that every run multiplies the same stored matrix. Opens it and
+// reports the mapping time, warning when its seed is not HPC_SEED; NULL when
+// MATRIX_FILE is not set or the file does not exist yet.
+BandFile *band_file_open_input(void);
+
+// Writes a generated A to MATRIX_FILE for the next runs, when it is set
+void band_file_save_input(const TridiagMatrix *A);
+
+#endif
@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+
+#include "checkpoint.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CHECKPOINT_MAGIC 0x54504b43u // "CKPT"
+#define CHECKPOINT_VERSION 1u
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  Checkpoint c;
+} CheckpointFile;
+
+char *checkpoint_path(const char *name, int rank) {
+  const char *prefix = getenv("SERIES_CHECKPOINT");
+  if (prefix == NULL || prefix[0] == '\0')
+    return NULL;
+
+  size_t len = strlen(prefix) + strlen(name) + 16;
+  char *path = malloc(len);
+  snprintf(path, len, "%s.%s.%d", prefix, name, rank);
+  return path;
+}
+
+double checkpoint_interval(void) {
+  const char *env = getenv("SERIES_CHECKPOINT_EVERY");
+  double every = env != NULL ? atof(env) : 0;
+  return every > 0 ? every : 60.0;
+}
+
+int checkpoint_load(const char *path, Checkpoint *c) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+    return 0;
+
+  CheckpointFile f;
+  size_t got = fread(&f, sizeof(f), 1, file);
+  fclose(file);
+
+  if (got != 1 || f.magic != CHECKPOINT_MAGIC ||
+      f.version != CHECKPOINT_VERSION) {
+    fprintf(stderr, "Warning: ignoring unreadable checkpoint %s\n", path);
+    return 0;
+  }
+  if (f.c.first != c->first || f.c.last != c->last || f.c.rank != c->rank ||
+      f.c.size != c->size || f.c.next < c->first || f.c.next > c->last + 1) {
+    fprintf(stderr, "Warning: checkpoint %s is for another run, ignored\n",
+            path);
+    return 0;
+  }
+
+  *c = f.c;
+  return 1;
+}
+
+void checkpoint_save(const char *path, const Checkpoint *c) {
+  CheckpointFile f;
+  memset(&f, 0, sizeof(f));
+  f.magic = CHECKPOINT_MAGIC;
+  f.version = CHECKPOINT_VERSION;
+  f.c = *c;
+
+  // Written next to the old one and renamed over it, so a kill in the middle
+  // of a write leaves the previous checkpoint intact
+  size_t len = strlen(path) + 5;
+  char *tmp = malloc(len);
+  snprintf(tmp, len, "%s.tmp", path);
+
+  FILE *file = fopen(tmp, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open file %s for writing\n", tmp);
+    free(tmp);
+    return;
+  }
+  int ok = fwrite(&f, sizeof(f), 1, file) == 1 && fflush(file) == 0 &&
+           fsync(fileno(file)) == 0;
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || rename(tmp, path) != 0) {
+    fprintf(stderr, "Error: Could not write checkpoint %s\n", path);
+    remove(tmp);
+  }
+  free(tmp);
+}
+
+void checkpoint_remove(const char *path) { remove(path); }
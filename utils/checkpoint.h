@@ -0,0 +1,38 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Per-rank checkpoints of a long reduction over the range first .. last:
+// the next index to process and the compensated partial sum so far, in a
+// small binary file written atomically (temporary file, fsync, rename).
+//
+// Enabled by the SERIES_CHECKPOINT environment variable, the path prefix of
+// the files (<prefix>.<name>.<rank>), written every SERIES_CHECKPOINT_EVERY
+// seconds (default 60). A run started with the same range, rank and number
+// of ranks resumes from the file; the file is removed once the range is done.
+
+typedef struct {
+  long long first; // range of the rank
+  long long last;
+  int rank;
+  int size;
+  long long next; // first index not yet summed
+  double sum;     // partial Kahan sum of first .. next - 1
+  double comp;
+} Checkpoint;
+
+// Path of the checkpoint of a run and rank, NULL when checkpoints are off.
+// The returned string is owned by the caller.
+char *checkpoint_path(const char *name, int rank);
+
+// Seconds between two checkpoints
+double checkpoint_interval(void);
+
+// Loads the checkpoint at path into c when it exists and matches the range,
+// rank and size already set in c. Returns 1 on resume, 0 otherwise.
+int checkpoint_load(const char *path, Checkpoint *c);
+
+void checkpoint_save(const char *path, const Checkpoint *c);
+
+void checkpoint_remove(const char *path);
+
+#endif
@@ -0,0 +1,338 @@
+#include "narrow.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Largest |entry| of a TridiagMatrix8 for which A^2 still fits in int16
+#define SQUARE8_MAX_ABS 104
+
+static void *narrow_alloc(size_t count, size_t size) {
+  void *p = malloc(count * size);
+  if (p == NULL) {
+    fprintf(stderr, "Error: Could not allocate narrow array of size %zu\n",
+            count);
+    exit(1);
+  }
+  return p;
+}
+
+static void range_error(int value, int index, int bits) {
+  fprintf(stderr, "Error: value %d at index %d does not fit in %d bits\n",
+          value, index, bits);
+  exit(1);
+}
+
+// Reports the first value of src outside [lo, hi]
+static void find_range_error(const int *src, int count, int lo, int hi,
+                             int bits) {
+  for (int i = 0; i < count; i++) {
+    if (src[i] < lo || src[i] > hi)
+      range_error(src[i], i, bits);
+  }
+}
+
+// The conversions run with the static partition of the kernels, so the
+// narrow arrays are first touched by the threads that later read them
+static int8_t *narrow8(const int *src, int count, int *max_abs,
+                       int num_threads) {
+  int8_t *dst = narrow_alloc(count, sizeof(int8_t));
+  int bad = 0;
+  int m = 0;
+
+#pragma omp parallel for schedule(static) num_threads(num_threads)           \
+    reduction(| : bad) reduction(max : m)
+  for (int i = 0; i < count; i++) {
+    int v = src[i];
+    bad |= v < INT8_MIN || v > INT8_MAX;
+    dst[i] = (int8_t)v;
+    m = abs(v) > m ? abs(v) : m;
+  }
+
+  if (bad)
+    find_range_error(src, count, INT8_MIN, INT8_MAX, 8);
+  if (m > *max_abs)
+    *max_abs = m;
+  return dst;
+}
+
+static int16_t *narrow16(const int *src, int count, int num_threads) {
+  int16_t *dst = narrow_alloc(count, sizeof(int16_t));
+  int bad = 0;
+
+#pragma omp parallel for schedule(static) num_threads(num_threads)           \
+    reduction(| : bad)
+  for (int i = 0; i < count; i++) {
+    int v = src[i];
+    bad |= v < INT16_MIN || v > INT16_MAX;
+    dst[i] = (int16_t)v;
+  }
+
+  if (bad)
+    find_range_error(src, count, INT16_MIN, INT16_MAX, 16);
+  return dst;
+}
+
+int8_t *narrow_vec8(const int *vec, int n, int num_threads) {
+  int max_abs = 0;
+  return narrow8(vec, n, &max_abs, num_threads);
+}
+
+int16_t *narrow_vec16(const int *vec, int n, int num_threads) {
+  return narrow16(vec, n, num_threads);
+}
+
+TridiagMatrix8 *narrow_tridiagonal8(const TridiagMatrix *A, int num_threads) {
+  TridiagMatrix8 *m = narrow_alloc(1, sizeof(TridiagMatrix8));
+  m->n = A->n;
+  m->max_abs = 0;
+  m->lower = narrow8(A->lower, A->n - 1, &m->max_abs, num_threads);
+  m->main = narrow8(A->main, A->n, &m->max_abs, num_threads);
+  m->upper = narrow8(A->upper, A->n - 1, &m->max_abs, num_threads);
+  return m;
+}
+
+TridiagMatrix16 *narrow_tridiagonal16(const TridiagMatrix *A,
+                                      int num_threads) {
+  TridiagMatrix16 *m = narrow_alloc(1, sizeof(TridiagMatrix16));
+  m->n = A->n;
+  m->lower = narrow16(A->lower, A->n - 1, num_threads);
+  m->main = narrow16(A->main, A->n, num_threads);
+  m->upper = narrow16(A->upper, A->n - 1, num_threads);
+  return m;
+}
+
+// Fills from a stream in parallel, checking every generated value
+static int8_t *random_narrow8(int count, int stream, int num_threads,
+                              int *max_abs) {
+  int8_t *dst = narrow_alloc(count, sizeof(int8_t));
+  uint64_t key = rng_stream(get_seed(), stream);
+  int bad = 0;
+  int m = 0;
+
+#pragma omp parallel for schedule(static) num_threads(num_threads)           \
+    reduction(| : bad) reduction(max : m)
+  for (int i = 0; i < count; i++) {
+    int v = rng_value(key, i);
+    bad |= v < INT8_MIN || v > INT8_MAX;
+    dst[i] = (int8_t)v;
+    m = abs(v) > m ? abs(v) : m;
+  }
+
+  if (bad) {
+    fprintf(stderr, "Error: generated values do not fit in 8 bits\n");
+    exit(1);
+  }
+
+  if (m > *max_abs)
+    *max_abs = m;
+  return dst;
+}
+
+int8_t *random_vec8(int n, int stream, int num_threads) {
+  int max_abs = 0;
+  return random_narrow8(n, stream, num_threads, &max_abs);
+}
+
+TridiagMatrix8 *random_opti_tridiagonal_matrix8(int n, int num_threads) {
+
+  if (n <= 1) {
+    fprintf(stderr, "Error : n must be greater than 1\n");
+    exit(1);
+  }
+
+  TridiagMatrix8 *m = narrow_alloc(1, sizeof(TridiagMatrix8));
+  m->n = n;
+  m->max_abs = 0;
+  m->lower = random_narrow8(n - 1, RNG_STREAM_LOWER, num_threads, &m->max_abs);
+  m->main = random_narrow8(n, RNG_STREAM_MAIN, num_threads, &m->max_abs);
+  m->upper = random_narrow8(n - 1, RNG_STREAM_UPPER, num_threads, &m->max_abs);
+  return m;
+}
+
+void free_tridiagonal8(TridiagMatrix8 *m) {
+  if (!m)
+    return;
+  free(m->lower);
+  free(m->main);
+  free(m->upper);
+  free(m);
+}
+
+void free_tridiagonal16(TridiagMatrix16 *m) {
+  if (!m)
+    return;
+  free(m->lower);
+  free(m->main);
+  free(m->upper);
+  free(m);
+}
+
+void free_penta16(PentaDiagMatrix16 *m) {
+  if (!m)
+    return;
+  free(m->main);
+  free(m->upper1);
+  free(m->upper2);
+  free(m->lower1);
+  free(m->lower2);
+  free(m);
+}
+
+// ################################################################################
+// y = A x, narrow loads widened to int
+// ################################################################################
+
+int *omp_matrix8_vector_multiplication(TridiagMatrix8 *matrix, int8_t *vec,
+                                       int n, int num_threads) {
+
+  int *result = malloc(n * sizeof(int));
+  const int8_t *L = matrix->lower;
+  const int8_t *M = matrix->main;
+  const int8_t *U = matrix->upper;
+
+  result[0] = M[0] * vec[0] + U[0] * vec[1];
+  result[n - 1] = L[n - 2] * vec[n - 2] + M[n - 1] * vec[n - 1];
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(static)
+  for (int i = 1; i < n - 1; i++) {
+    result[i] = (int)L[i - 1] * vec[i - 1] + (int)M[i] * vec[i] +
+                (int)U[i] * vec[i + 1];
+  }
+
+  return result;
+}
+
+int *omp_matrix16_vector_multiplication(TridiagMatrix16 *matrix, int16_t *vec,
+                                        int n, int num_threads) {
+
+  int *result = malloc(n * sizeof(int));
+  const int16_t *L = matrix->lower;
+  const int16_t *M = matrix->main;
+  const int16_t *U = matrix->upper;
+
+  result[0] = M[0] * vec[0] + U[0] * vec[1];
+  result[n - 1] = L[n - 2] * vec[n - 2] + M[n - 1] * vec[n - 1];
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(static)
+  for (int i = 1; i < n - 1; i++) {
+    result[i] = (int)L[i - 1] * vec[i - 1] + (int)M[i] * vec[i] +
+                (int)U[i] * vec[i + 1];
+  }
+
+  return result;
+}
+
+// ################################################################################
+// A^2, same formulas as compute_square_tridiagonal_omp
+// ################################################################################
+
+// Row i with the boundary tests, for the first and last rows
+static void square8_row(const TridiagMatrix8 *A, PentaDiagMatrix16 *R, int i) {
+  int n = A->n;
+  const int8_t *M = A->main;
+  const int8_t *U = A->upper;
+  const int8_t *L = A->lower;
+
+  int val = M[i] * M[i];
+  if (i > 0)
+    val += L[i - 1] * U[i - 1];
+  if (i < n - 1)
+    val += U[i] * L[i];
+  R->main[i] = (int16_t)val;
+
+  if (i < n - 1) {
+    R->upper1[i] = (int16_t)(M[i] * U[i] + U[i] * M[i + 1]);
+    R->lower1[i] = (int16_t)(L[i] * M[i] + M[i + 1] * L[i]);
+  }
+  if (i < n - 2) {
+    R->upper2[i] = (int16_t)(U[i] * U[i + 1]);
+    R->lower2[i] = (int16_t)(L[i + 1] * L[i]);
+  }
+}
+
+PentaDiagMatrix16 *compute_square_tridiagonal8_omp(TridiagMatrix8 *A,
+                                                   int num_threads) {
+  int n = A->n;
+
+  if (A->max_abs > SQUARE8_MAX_ABS) {
+    fprintf(stderr,
+            "Error: entries up to %d, A^2 does not fit in 16 bits (max %d)\n",
+            A->max_abs, SQUARE8_MAX_ABS);
+    exit(1);
+  }
+
+  PentaDiagMatrix16 *R = narrow_alloc(1, sizeof(PentaDiagMatrix16));
+  R->n = n;
+  R->main = narrow_alloc(n, sizeof(int16_t));
+  R->upper1 = narrow_alloc(n - 1, sizeof(int16_t));
+  R->upper2 = narrow_alloc(n > 2 ? n - 2 : 1, sizeof(int16_t));
+  R->lower1 = narrow_alloc(n - 1, sizeof(int16_t));
+  R->lower2 = narrow_alloc(n > 2 ? n - 2 : 1, sizeof(int16_t));
+
+  const int8_t *M = A->main;
+  const int8_t *U = A->upper;
+  const int8_t *L = A->lower;
+
+  // Rows 1 .. n-3 have every term, the rest goes through square8_row
+  omp_set_dynamic(0);
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(static)
+  for (int i = 1; i < n - 2; i++) {
+    R->main[i] = (int16_t)(M[i] * M[i] + L[i - 1] * U[i - 1] + U[i] * L[i]);
+    R->upper1[i] = (int16_t)(M[i] * U[i] + U[i] * M[i + 1]);
+    R->upper2[i] = (int16_t)(U[i] * U[i + 1]);
+    R->lower1[i] = (int16_t)(L[i] * M[i] + M[i + 1] * L[i]);
+    R->lower2[i] = (int16_t)(L[i + 1] * L[i]);
+  }
+
+  square8_row(A, R, 0);
+  for (int i = n - 2 > 1 ? n - 2 : 1; i < n; i++)
+    square8_row(A, R, i);
+
+  return R;
+}
+
+PentaDiagMatrix *compute_square_tridiagonal16_omp(TridiagMatrix16 *A,
+                                                  int num_threads) {
+  int n = A->n;
+  PentaDiagMatrix *R = malloc(sizeof(PentaDiagMatrix));
+  R->n = n;
+  R->main = malloc(n * sizeof(int));
+  R->upper1 = malloc((n - 1) * sizeof(int));
+  R->upper2 = malloc((n - 2) * sizeof(int));
+  R->lower1 = malloc((n - 1) * sizeof(int));
+  R->lower2 = malloc((n - 2) * sizeof(int));
+
+  const int16_t *M = A->main;
+  const int16_t *U = A->upper;
+  const int16_t *L = A->lower;
+
+  // 16-bit products fit in int, their sums are accumulated in 64 bits
+  omp_set_dynamic(0);
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < n; i++) {
+    long long val = (long long)M[i] * M[i];
+    if (i > 0)
+      val += L[i - 1] * U[i - 1];
+    if (i < n - 1)
+      val += U[i] * L[i];
+    R->main[i] = (int)val;
+
+    if (i < n - 1) {
+      R->upper1[i] = (int)((long long)M[i] * U[i] + U[i] * M[i + 1]);
+      R->lower1[i] = (int)((long long)L[i] * M[i] + M[i + 1] * L[i]);
+    }
+
+    if (i < n - 2) {
+      R->upper2[i] = U[i] * U[i + 1];
+      R->lower2[i] = L[i + 1] * L[i];
+    }
+  }
+
+  return R;
+}
@@ -0,0 +1,79 @@
+#ifndef NARROW_H
+#define NARROW_H
+
+#include "utils.h"
+#include <stdint.h>
+
+// Narrow storage for the tridiagonal kernels. Generated entries are in
+// [-10, 10], so they fit in 8 bits; the kernels load the narrow values and
+// widen them in registers, which cuts the bytes moved per row.
+// Every conversion checks the range and stops on a value that does not fit.
+
+// Bytes per row of the int8 kernels (same ops as the int kernels):
+// y = A x reads 3 + 1 bytes and writes an int, A^2 reads 3 and writes 5 int16
+#define TRIDIAG8_MATVEC_BYTES 8
+#define SQUARE8_TRIDIAG_BYTES 13
+
+typedef struct {
+  int n;
+  int max_abs;   // largest |entry|, set when the matrix is built
+  int8_t *lower; // sub diagonal
+  int8_t *main;  // diagonal
+  int8_t *upper; // super diagonal
+} TridiagMatrix8;
+
+typedef struct {
+  int n;
+  int16_t *lower; // sub diagonal
+  int16_t *main;  // diagonal
+  int16_t *upper; // super diagonal
+} TridiagMatrix16;
+
+// A^2 of a TridiagMatrix8. Its entries are bounded by 3 * max_abs^2, which
+// fits in 16 bits as long as max_abs <= 104 (checked by the kernel)
+typedef struct {
+  int n;
+  int16_t *lower2; // sub-sub diagonal (i-2)
+  int16_t *lower1; // sub diagonal (i-1)
+  int16_t *main;   // diagonal (i)
+  int16_t *upper1; // super diagonal (i+1)
+  int16_t *upper2; // super-super diagonal (i+2)
+} PentaDiagMatrix16;
+
+// Conversions of existing int data, in parallel with the static partition
+// of num_threads threads (first touch like the kernels)
+int8_t *narrow_vec8(const int *vec, int n, int num_threads);
+
+int16_t *narrow_vec16(const int *vec, int n, int num_threads);
+
+TridiagMatrix8 *narrow_tridiagonal8(const TridiagMatrix *A, int num_threads);
+
+TridiagMatrix16 *narrow_tridiagonal16(const TridiagMatrix *A,
+                                      int num_threads);
+
+// Same values as random_vec / random_opti_tridiagonal_matrix, generated
+// straight into narrow storage (stream is RNG_STREAM_VEC + k for the k-th
+// vector of a program)
+int8_t *random_vec8(int n, int stream, int num_threads);
+
+TridiagMatrix8 *random_opti_tridiagonal_matrix8(int n, int num_threads);
+
+void free_tridiagonal8(TridiagMatrix8 *m);
+
+void free_tridiagonal16(TridiagMatrix16 *m);
+
+void free_penta16(PentaDiagMatrix16 *m);
+
+int *omp_matrix8_vector_multiplication(TridiagMatrix8 *matrix, int8_t *vec,
+                                       int n, int num_threads);
+
+int *omp_matrix16_vector_multiplication(TridiagMatrix16 *matrix, int16_t *vec,
+                                        int n, int num_threads);
+
+PentaDiagMatrix16 *compute_square_tridiagonal8_omp(TridiagMatrix8 *A,
+                                                   int num_threads);
+
+PentaDiagMatrix *compute_square_tridiagonal16_omp(TridiagMatrix16 *A,
+                                                  int num_threads);
+
+#endif
@@ -0,0 +1,265 @@
+#define _GNU_SOURCE
+
+#include "perf.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static const char *event_names[PERF_NEVENTS] = {
+    "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"};
+
+static int fds[PERF_MAX_THREADS][PERF_NEVENTS];
+static int open_threads = 0; // threads of the running region
+static PerfValues last[PERF_MAX_THREADS];
+static int last_threads = 0; // threads of the last stopped region
+static int warned = 0;
+
+int perf_enabled(void) {
+  const char *env = getenv("PERF_COUNTERS");
+  return env != NULL && env[0] != '\0';
+}
+
+#ifdef __linux__
+
+static void event_attr(int event, struct perf_event_attr *attr) {
+  memset(attr, 0, sizeof(*attr));
+  attr->size = sizeof(*attr);
+  attr->disabled = 1;
+  attr->exclude_kernel = 1; // allowed with perf_event_paranoid <= 2
+  attr->exclude_hv = 1;
+  // More events than hardware counters are multiplexed, the enabled and
+  // running times let us scale the counts back
+  attr->read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  switch (event) {
+  case PERF_CYCLES:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case PERF_INSTRUCTIONS:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case PERF_LLC_MISSES:
+    attr->type = PERF_TYPE_HW_CACHE;
+    attr->config = PERF_COUNT_HW_CACHE_LL |
+                   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    break;
+  case PERF_DTLB_MISSES:
+    attr->type = PERF_TYPE_HW_CACHE;
+    attr->config = PERF_COUNT_HW_CACHE_DTLB |
+                   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    break;
+  case PERF_BRANCH_MISSES:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  }
+}
+
+// Opens every event on the calling thread (pid 0, any cpu)
+static void open_thread(int t) {
+  for (int e = 0; e < PERF_NEVENTS; e++) {
+    struct perf_event_attr attr;
+    event_attr(e, &attr);
+    fds[t][e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fds[t][e] < 0 && !warned) {
+#pragma omp critical(perf_warn)
+      {
+        if (!warned)
+          fprintf(stderr, "perf: cannot count %s (%s)%s\n", event_names[e],
+                  strerror(errno),
+                  errno == EACCES || errno == EPERM
+                      ? ", check /proc/sys/kernel/perf_event_paranoid"
+                      : "");
+        warned = 1;
+      }
+    }
+  }
+}
+
+static void close_region(void) {
+  for (int t = 0; t < open_threads; t++) {
+    for (int e = 0; e < PERF_NEVENTS; e++) {
+      if (fds[t][e] >= 0)
+        close(fds[t][e]);
+    }
+  }
+  open_threads = 0;
+}
+
+#endif
+
+void perf_start(int num_threads) {
+  if (!perf_enabled())
+    return;
+
+#ifdef __linux__
+  close_region();
+
+  if (num_threads > PERF_MAX_THREADS) {
+    fprintf(stderr, "perf: only the first %d threads are counted\n",
+            PERF_MAX_THREADS);
+    num_threads = PERF_MAX_THREADS;
+  }
+
+#ifdef _OPENMP
+  // Same team size as the kernel, so its parallel regions run on these threads
+  int team = 1;
+#pragma omp parallel num_threads(num_threads)
+  {
+#pragma omp single
+    team = omp_get_num_threads();
+    open_thread(omp_get_thread_num());
+  }
+  open_threads = team;
+#else
+  open_thread(0);
+  open_threads = 1;
+#endif
+
+  for (int t = 0; t < open_threads; t++) {
+    for (int e = 0; e < PERF_NEVENTS; e++) {
+      if (fds[t][e] >= 0) {
+        ioctl(fds[t][e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[t][e], PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+#else
+  if (!warned)
+    fprintf(stderr, "perf: hardware counters need Linux perf_event_open\n");
+  warned = 1;
+#endif
+}
+
+void perf_stop(void) {
+#ifdef __linux__
+  if (open_threads == 0)
+    return;
+
+  for (int t = 0; t < open_threads; t++) {
+    for (int e = 0; e < PERF_NEVENTS; e++) {
+      if (fds[t][e] >= 0)
+        ioctl(fds[t][e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+
+  for (int t = 0; t < open_threads; t++) {
+    for (int e = 0; e < PERF_NEVENTS; e++) {
+      unsigned long long buf[3]; // value, time enabled, time running
+      last[t].count[e] = -1;
+      if (fds[t][e] >= 0 &&
+          read(fds[t][e], buf, sizeof(buf)) == sizeof(buf) && buf[2] > 0) {
+        last[t].count[e] = (long long)((double)buf[0] * buf[1] / buf[2]);
+      }
+    }
+  }
+
+  last_threads = open_threads;
+  close_region();
+#endif
+}
+
+int perf_last(PerfValues *total, PerfValues *per_thread) {
+  for (int e = 0; e < PERF_NEVENTS; e++) {
+    total->count[e] = last_threads > 0 ? 0 : -1;
+    for (int t = 0; t < last_threads; t++) {
+      if (last[t].count[e] < 0)
+        total->count[e] = -1;
+      else if (total->count[e] >= 0)
+        total->count[e] += last[t].count[e];
+    }
+  }
+
+  if (per_thread != NULL)
+    memcpy(per_thread, last, last_threads * sizeof(PerfValues));
+
+  return last_threads;
+}
+
+static void write_row(FILE *file, const char *method, long long size,
+                      int nb_process, const char *thread,
+                      const PerfValues *v) {
+  fprintf(file, "%s,%lld,%d,%s", method, size, nb_process, thread);
+  for (int e = 0; e < PERF_NEVENTS; e++)
+    fprintf(file, ",%lld", v->count[e]);
+  fprintf(file, "\n");
+}
+
+void perf_log(const char *time_filename, const char *method, long long size,
+              int nb_process) {
+  if (last_threads == 0)
+    return;
+
+  PerfValues total;
+  int nthreads = perf_last(&total, NULL);
+
+  // x.csv -> x_perf.csv
+  size_t len = strlen(time_filename);
+  if (len >= 4 && strcmp(time_filename + len - 4, ".csv") == 0)
+    len -= 4;
+  char *filename = malloc(len + sizeof("_perf.csv"));
+  memcpy(filename, time_filename, len);
+  strcpy(filename + len, "_perf.csv");
+
+  FILE *file = fopen(filename, "r");
+  int write_header = 0;
+  if (file == NULL) {
+    write_header = 1;
+  } else {
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+      write_header = 1;
+    }
+    fclose(file);
+  }
+
+  file = fopen(filename, "a");
+  if (file == NULL) {
+    fprintf(stderr, "Error: Could not open file %s for writing\n", filename);
+    free(filename);
+    return;
+  }
+
+  if (write_header) {
+    fprintf(file, "method,size,nb_proc,thread");
+    for (int e = 0; e < PERF_NEVENTS; e++)
+      fprintf(file, ",%s", event_names[e]);
+    fprintf(file, "\n");
+  }
+
+  write_row(file, method, size, nb_process, "all", &total);
+  for (int t = 0; t < nthreads; t++) {
+    char thread[16];
+    snprintf(thread, sizeof(thread), "%d", t);
+    write_row(file, method, size, nb_process, thread, &last[t]);
+  }
+  fclose(file);
+  free(filename);
+
+  printf("%s counters:", method);
+  for (int e = 0; e < PERF_NEVENTS; e++)
+    printf(" %s %lld", event_names[e], total.count[e]);
+  if (total.count[PERF_CYCLES] > 0 && total.count[PERF_INSTRUCTIONS] >= 0)
+    printf(" (IPC %.2f)", (double)total.count[PERF_INSTRUCTIONS] /
+                              total.count[PERF_CYCLES]);
+  printf("\n");
+
+  last_threads = 0;
+}
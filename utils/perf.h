@@ -0,0 +1,49 @@
+#ifndef PERF_H
+#define PERF_H
+
+// Hardware counters around a timed region, through perf_event_open.
+// Counting is off unless the PERF_COUNTERS environment variable is set, so
+// the calls can stay in every program at no cost.
+//
+//   perf_start(num_threads);
+//   start = omp_get_wtime();
+//   ... kernel ...
+//   end = omp_get_wtime();
+//   perf_stop();
+//   log_execution_time("x.csv", ...); // counters go to x_perf.csv
+//
+// perf_start opens the counters on the threads of the next parallel regions
+// (the OpenMP pool is reused as long as the thread count does not change),
+// perf_stop reads them and keeps them until the next log_execution_time.
+
+#define PERF_MAX_THREADS 256
+
+enum {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_LLC_MISSES,
+  PERF_DTLB_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_NEVENTS
+};
+
+typedef struct {
+  long long count[PERF_NEVENTS]; // -1 when the event could not be counted
+} PerfValues;
+
+int perf_enabled(void);
+
+void perf_start(int num_threads);
+
+void perf_stop(void);
+
+// Counters of the last stopped region: returns its thread count (0 if there
+// is none), fills total and, when per_thread is not NULL, one entry per thread
+int perf_last(PerfValues *total, PerfValues *per_thread);
+
+// Appends the last region to the companion file of time_filename
+// (x.csv -> x_perf.csv) and forgets it. Called by log_execution_time.
+void perf_log(const char *time_filename, const char *method, long long size,
+              int nb_process);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include "utils.h"
+
+// A^2 and A^3 of a tridiagonal matrix, diagonal by diagonal
+
+// Compulsory bytes and integer ops per row: A^2 reads 3 diagonals and writes
+// 5 (13 ops), A^3 reads the 3 + 5 diagonals of A and A^2 and writes 7 (23 ops)
+#define SQUARE_TRIDIAG_BYTES 32
+#define SQUARE_TRIDIAG_OPS 13
+#define CUBE_TRIDIAG_BYTES 60
+#define CUBE_TRIDIAG_OPS 23
+
+PentaDiagMatrix *compute_square_tridiagonal(TridiagMatrix *A);
+
+// A^3 = A * A^2
+HeptaDiagMatrix *compute_cube_tridiagonal(TridiagMatrix *A,
+                                          PentaDiagMatrix *A2);
+
+PentaDiagMatrix *compute_square_tridiagonal_omp(TridiagMatrix *A,
+                                                int num_threads);
+
+HeptaDiagMatrix *compute_cube_tridiagonal_omp(TridiagMatrix *A,
+                                              PentaDiagMatrix *A2,
+                                              int num_threads);
+
+void free_penta(PentaDiagMatrix *m);
+
+void free_hepta(HeptaDiagMatrix *m);
+
+#endif
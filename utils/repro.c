@@ -0,0 +1,92 @@
+#include "repro.h"
+#include <stddef.h>
+
+long long repro_nblocks(long long n) {
+  return (n + REPRO_BLOCK - 1) / REPRO_BLOCK;
+}
+
+void repro_block_range(long long b, long long n, long long *first,
+                       long long *last) {
+  *first = b * REPRO_BLOCK;
+  *last = *first + REPRO_BLOCK - 1 < n ? *first + REPRO_BLOCK - 1 : n - 1;
+}
+
+// The tree only depends on nblocks: halves split at nblocks / 2, leaves of
+// at most 8 sums added left to right
+double repro_combine(const double *blocks, long long nblocks) {
+  if (nblocks <= 8) {
+    double total = 0;
+    for (long long b = 0; b < nblocks; b++)
+      total += blocks[b];
+    return total;
+  }
+
+  long long half = nblocks / 2;
+  return repro_combine(blocks, half) +
+         repro_combine(blocks + half, nblocks - half);
+}
+
+double repro_tree_sum(long long first, long long nblocks,
+                      double (*block_sum)(long long b, void *ctx), void *ctx) {
+  if (nblocks <= 8) {
+    double total = 0;
+    for (long long b = 0; b < nblocks; b++)
+      total += block_sum(first + b, ctx);
+    return total;
+  }
+
+  long long half = nblocks / 2;
+  return repro_tree_sum(first, half, block_sum, ctx) +
+         repro_tree_sum(first + half, nblocks - half, block_sum, ctx);
+}
+
+static int split_depth(long long nparts) {
+  int depth = 0;
+  while ((1LL << depth) < nparts)
+    depth++;
+  return depth;
+}
+
+static void collect_subtrees(long long first, long long nblocks, int depth,
+                             long long *first_out, long long *count_out,
+                             long long *nsub) {
+  if (nblocks <= 8 || depth == 0) {
+    if (first_out != NULL) {
+      first_out[*nsub] = first;
+      count_out[*nsub] = nblocks;
+    }
+    (*nsub)++;
+    return;
+  }
+
+  long long half = nblocks / 2;
+  collect_subtrees(first, half, depth - 1, first_out, count_out, nsub);
+  collect_subtrees(first + half, nblocks - half, depth - 1, first_out,
+                   count_out, nsub);
+}
+
+long long repro_subtrees(long long nblocks, long long nparts, long long *first,
+                         long long *count) {
+  long long nsub = 0;
+  collect_subtrees(0, nblocks, split_depth(nparts), first, count, &nsub);
+  return nsub;
+}
+
+// Walks the subtrees in the order of collect_subtrees, *next being the
+// index of the next unused sum
+static double combine_top(const double *sums, long long nblocks, int depth,
+                          long long *next) {
+  if (nblocks <= 8 || depth == 0)
+    return sums[(*next)++];
+
+  long long half = nblocks / 2;
+  double left = combine_top(sums, half, depth - 1, next);
+  double right = combine_top(sums, nblocks - half, depth - 1, next);
+  return left + right;
+}
+
+double repro_combine_subtrees(const double *sums, long long nblocks,
+                              long long nparts) {
+  long long next = 0;
+  return combine_top(sums, nblocks, split_depth(nparts), &next);
+}
@@ -0,0 +1,39 @@
+#ifndef REPRO_H
+#define REPRO_H
+
+// Reproducible reductions: the range is cut into blocks of REPRO_BLOCK
+// elements whatever the number of threads or ranks, every block is summed
+// on its own and the block sums are combined in a fixed pairwise tree. The
+// additions, and so the bits of the result, only depend on the range; the
+// workers only decide who computes which block.
+
+#define REPRO_BLOCK 65536
+
+// Number of blocks of a range of n elements
+long long repro_nblocks(long long n);
+
+// First and last (inclusive) 0-based element of block b
+void repro_block_range(long long b, long long n, long long *first,
+                       long long *last);
+
+// Fixed pairwise sum of the block sums blocks[0 .. nblocks)
+double repro_combine(const double *blocks, long long nblocks);
+
+// Same tree over blocks first .. first + nblocks - 1, each block sum computed
+// by block_sum(b, ctx) when it is needed instead of being stored
+double repro_tree_sum(long long first, long long nblocks,
+                      double (*block_sum)(long long b, void *ctx), void *ctx);
+
+// Distributed form: the tree is cut at the first depth with at least nparts
+// nodes (leaves above it stay whole), which gives fewer than 2 * nparts
+// subtrees. Subtree s covers count[s] blocks from first[s], left to right.
+// Returns their number; first and count may be NULL to only count them.
+long long repro_subtrees(long long nblocks, long long nparts, long long *first,
+                         long long *count);
+
+// repro_combine from the sums of the subtrees of repro_subtrees(nblocks,
+// nparts), each one summed with repro_tree_sum or repro_combine: same bits
+double repro_combine_subtrees(const double *sums, long long nblocks,
+                              long long nparts);
+
+#endif
@@ -0,0 +1,75 @@
+#include "roofline.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+double roofline_bandwidth(int num_threads) {
+  const char *filename = getenv("STREAM_FILE");
+  if (filename == NULL || filename[0] == '\0')
+    filename = "stream.csv";
+
+  FILE *file = fopen(filename, "r");
+  if (file == NULL)
+    return 0;
+
+  // threads,copy,scale,add,triad
+  char line[256];
+  int best_threads = 0;
+  int min_threads = 0;
+  double best = 0;
+  double at_min = 0;
+  while (fgets(line, sizeof(line), file)) {
+    int threads;
+    double copy, scale, add, triad;
+    if (sscanf(line, "%d,%lf,%lf,%lf,%lf", &threads, &copy, &scale, &add,
+               &triad) != 5)
+      continue; // header
+    if (threads <= num_threads && threads > best_threads) {
+      best_threads = threads;
+      best = triad;
+    }
+    if (min_threads == 0 || threads < min_threads) {
+      min_threads = threads;
+      at_min = triad;
+    }
+  }
+  fclose(file);
+
+  return best_threads > 0 ? best : at_min;
+}
+
+static double roofline_peak(void) {
+  const char *env = getenv("ROOFLINE_PEAK_GOPS");
+  return env != NULL && env[0] != '\0' ? atof(env) : 0;
+}
+
+double roofline_percent(double bytes, double ops, double time,
+                        int num_threads) {
+  double bandwidth = roofline_bandwidth(num_threads);
+  double peak = roofline_peak();
+  double ceiling = peak; // Gop/s
+
+  if (bytes > 0 && bandwidth > 0) {
+    double memory = ops / bytes * bandwidth;
+    if (ceiling == 0 || memory < ceiling)
+      ceiling = memory;
+  }
+
+  if (ceiling <= 0 || time <= 0)
+    return -1;
+  return 100.0 * ops / time * 1e-9 / ceiling;
+}
+
+void roofline_report(const char *name, double bytes, double ops, double time,
+                     int num_threads) {
+  double percent = roofline_percent(bytes, ops, time, num_threads);
+
+  printf("%s: ", name);
+  if (bytes > 0)
+    printf("intensity %.3f op/B, %.2f GB/s, ", ops / bytes,
+           bytes / time * 1e-9);
+  printf("%.2f Gop/s", ops / time * 1e-9);
+  if (percent >= 0)
+    printf(", %.1f%% of roofline\n", percent);
+  else
+    printf(" (no roofline: run stream_probe or set ROOFLINE_PEAK_GOPS)\n");
+}
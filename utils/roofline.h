@@ -0,0 +1,23 @@
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+// Roofline of the host, from the stream_probe results.
+// The memory ceiling is the triad bandwidth of the file named by STREAM_FILE
+// (default stream.csv) for the largest measured thread count <= the run's.
+// The compute ceiling is ROOFLINE_PEAK_GOPS (Gop/s) when it is set, otherwise
+// only the memory ceiling applies.
+
+// Triad bandwidth in GB/s for num_threads, 0 if there is no stream file
+double roofline_bandwidth(int num_threads);
+
+// Share (in %) of min(peak, intensity * bandwidth) reached by a run that did
+// ops operations and moved bytes bytes in time seconds, -1 if no ceiling
+// applies (no stream file, or no traffic and no peak)
+double roofline_percent(double bytes, double ops, double time,
+                        int num_threads);
+
+// Prints intensity, achieved bandwidth and rate, and the roofline share
+void roofline_report(const char *name, double bytes, double ops, double time,
+                     int num_threads);
+
+#endif
@@ -0,0 +1,65 @@
+#include "series.h"
+#include "repro.h"
+#include "series_terms.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+double series_term(long long i) { return ex1_term((double)i); }
+
+double sequential_series_sum(long long n) {
+
+  double total = 0;
+
+  for (long long i = 1; i <= n; i++) {
+    total += series_term(i);
+  }
+
+  return total;
+}
+
+double omp_series_sum(long long n, int num_threads) {
+
+  double total = 0;
+
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for reduction(+ : total) schedule(static)
+  for (long long i = 1; i <= n; i++) {
+    total += series_term(i);
+  }
+
+  return total;
+}
+
+double series_block_sum(long long b, long long n) {
+  long long first, last;
+  repro_block_range(b, n, &first, &last);
+
+  double total = 0;
+  for (long long i = first + 1; i <= last + 1; i++) {
+    total += series_term(i);
+  }
+
+  return total;
+}
+
+double repro_series_sum(long long n, int num_threads) {
+
+  long long nblocks = repro_nblocks(n);
+  double *blocks = malloc(nblocks * sizeof(double));
+  if (blocks == NULL && nblocks > 0) {
+    fprintf(stderr, "Error: Could not allocate %lld block sums\n", nblocks);
+    exit(1);
+  }
+
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(static)
+  for (long long b = 0; b < nblocks; b++) {
+    blocks[b] = series_block_sum(b, n);
+  }
+
+  double total = repro_combine(blocks, nblocks);
+  free(blocks);
+
+  return total;
+}
@@ -0,0 +1,24 @@
+#ifndef SERIES_H
+#define SERIES_H
+
+// Partial sums of sum_{i >= 1} 1 / (i (i + 1)), which tends to 1
+
+// Per term: no memory traffic, one addition, one multiplication and one
+// division for the term plus one addition to accumulate it
+#define SERIES_BYTES 0
+#define SERIES_OPS 4
+
+// Indices are 64-bit: the term is exact in double precision up to 2^53
+double series_term(long long i);
+
+double sequential_series_sum(long long n);
+
+double omp_series_sum(long long n, int num_threads);
+
+// Sum of block b of the terms 1 .. n, blocks as in repro.h
+double series_block_sum(long long b, long long n);
+
+// Same bits for any num_threads: fixed blocks, fixed combination order
+double repro_series_sum(long long n, int num_threads);
+
+#endif
@@ -0,0 +1,171 @@
+// Series summation engine: a template header that generates fully inlined
+// kernels for one series. Define the name and the term, then include it:
+//
+//   #define SERIES_NAME basel
+//   #define SERIES_TERM(i) basel_term(i) // i is a long long, i >= 1
+//   #include "series_engine.h"
+//
+// which defines, as static functions (the term is inlined in every loop,
+// there is no call through a pointer):
+//
+//   double basel_seq(long long first, long long last);   // plain loop
+//   double basel_simd(long long first, long long last);  // lanes + Kahan
+//   double basel_omp(long long first, long long last, int num_threads);
+//   double basel_mpi(long long n, int num_threads, MPI_Comm comm);
+//
+// basel_mpi is only generated when mpi.h is included before this header.
+// The SIMD kernel keeps SERIES_ENGINE_LANES independent Kahan sums that the
+// compiler vectorizes (#pragma omp simd); on x86-64 Linux it is cloned for
+// avx512f and avx2 and picked at load time. Compile with OpenMP.
+//
+// SERIES_TERM must be pure: the lanes evaluate it in any order. It gets the
+// index as a long long and, in the SIMD kernel, also as an exact double
+// through SERIES_TERM_D(d, i) when that macro is defined (cheaper than
+// converting the index in every lane).
+
+#ifndef SERIES_ENGINE_COMMON
+#define SERIES_ENGINE_COMMON
+
+#include <omp.h>
+#include <stdlib.h>
+
+#define SERIES_ENGINE_LANES 16
+
+#define SERIES_ENGINE_CAT2(a, b) a##_##b
+#define SERIES_ENGINE_CAT(a, b) SERIES_ENGINE_CAT2(a, b)
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(__clang__)
+#define SERIES_ENGINE_CLONES                                                  \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SERIES_ENGINE_CLONES
+#endif
+
+typedef struct {
+  double sum;
+  double comp;
+} SeriesEngineSum;
+
+static inline void series_engine_add(SeriesEngineSum *k, double v) {
+  double y = v - k->comp;
+  double t = k->sum + y;
+  k->comp = (t - k->sum) - y;
+  k->sum = t;
+}
+
+#endif
+
+#ifndef SERIES_NAME
+#error "define SERIES_NAME before including series_engine.h"
+#endif
+#ifndef SERIES_TERM
+#error "define SERIES_TERM(i) before including series_engine.h"
+#endif
+#ifndef SERIES_TERM_D
+#define SERIES_TERM_D(d, i) SERIES_TERM(i)
+#endif
+
+#define SERIES_FN(suffix) SERIES_ENGINE_CAT(SERIES_NAME, suffix)
+
+static inline double SERIES_FN(seq)(long long first, long long last) {
+  double total = 0;
+  for (long long i = first; i <= last; i++)
+    total += SERIES_TERM(i);
+  return total;
+}
+
+// Lane l handles first + l, first + l + LANES, ... with its own Kahan sum
+SERIES_ENGINE_CLONES
+static void SERIES_FN(simd_kahan)(long long first, long long last,
+                                  SeriesEngineSum *k) {
+  double s[SERIES_ENGINE_LANES] = {0};
+  double c[SERIES_ENGINE_LANES] = {0};
+
+  long long i = first;
+  double base = (double)first;
+  for (; i + SERIES_ENGINE_LANES - 1 <= last;
+       i += SERIES_ENGINE_LANES, base += SERIES_ENGINE_LANES) {
+#pragma omp simd
+    for (int l = 0; l < SERIES_ENGINE_LANES; l++) {
+      double d = base + l;
+      double t = SERIES_TERM_D(d, i + l);
+      double y = t - c[l];
+      double u = s[l] + y;
+      c[l] = (u - s[l]) - y;
+      s[l] = u;
+    }
+  }
+
+  for (int l = 0; l < SERIES_ENGINE_LANES; l++) {
+    series_engine_add(k, s[l]);
+    series_engine_add(k, -c[l]);
+  }
+  for (; i <= last; i++)
+    series_engine_add(k, SERIES_TERM(i));
+}
+
+static inline double SERIES_FN(simd)(long long first, long long last) {
+  SeriesEngineSum k = {0, 0};
+  if (first <= last)
+    SERIES_FN(simd_kahan)(first, last, &k);
+  return k.sum - k.comp;
+}
+
+// Contiguous block per thread, partial sums combined in thread order
+static inline double SERIES_FN(omp)(long long first, long long last,
+                                    int num_threads) {
+  if (first > last)
+    return 0.0;
+
+  SeriesEngineSum *partial = calloc(num_threads, sizeof(SeriesEngineSum));
+  int nb = num_threads;
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+#pragma omp single
+    nb = omp_get_num_threads();
+
+    long long chunk = (last - first + nb) / nb;
+    long long lo = first + t * chunk;
+    long long hi = lo + chunk - 1 < last ? lo + chunk - 1 : last;
+    if (lo <= hi)
+      SERIES_FN(simd_kahan)(lo, hi, &partial[t]);
+  }
+
+  SeriesEngineSum k = {0, 0};
+  for (int t = 0; t < nb; t++) {
+    series_engine_add(&k, partial[t].sum);
+    series_engine_add(&k, -partial[t].comp);
+  }
+
+  free(partial);
+  return k.sum - k.comp;
+}
+
+#ifdef MPI_VERSION
+// Terms 1 .. n: a contiguous block per rank, num_threads threads per rank
+// (only the calling thread uses MPI). Every rank gets the total.
+static inline double SERIES_FN(mpi)(long long n, int num_threads,
+                                    MPI_Comm comm) {
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+
+  long long chunk = (n + size - 1) / size;
+  long long first = 1 + rank * chunk;
+  long long last = first + chunk - 1 < n ? first + chunk - 1 : n;
+
+  double local = SERIES_FN(omp)(first, last, num_threads);
+  double total = 0.0;
+  MPI_Allreduce(&local, &total, 1, MPI_DOUBLE, MPI_SUM, comm);
+  return total;
+}
+#endif
+
+#undef SERIES_FN
+#undef SERIES_TERM_D
+#undef SERIES_TERM
+#undef SERIES_NAME
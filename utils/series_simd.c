@@ -0,0 +1,302 @@
+#include "series_simd.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SERIES_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define SERIES_NEON 1
+#include <arm_neon.h>
+#endif
+
+// A running sum with its Kahan compensation: the value is sum - comp
+typedef struct {
+  double sum;
+  double comp;
+} KahanSum;
+
+typedef void (*series_range_fn)(long long first, long long last, KahanSum *k);
+
+static void kahan_add(KahanSum *k, double v) {
+  double y = v - k->comp;
+  double t = k->sum + y;
+  k->comp = (t - k->sum) - y;
+  k->sum = t;
+}
+
+// Folds the per-lane sums and compensations of a vector kernel into k
+static void kahan_add_lanes(KahanSum *k, const double *sum, const double *comp,
+                            int lanes) {
+  for (int l = 0; l < lanes; l++) {
+    kahan_add(k, sum[l]);
+    kahan_add(k, -comp[l]);
+  }
+}
+
+static void range_scalar(long long first, long long last, KahanSum *k) {
+  for (long long i = first; i <= last; i++)
+    kahan_add(k, 1.0 / ((double)i * (i + 1)));
+}
+
+// The vector kernels run two independent accumulators so the Kahan update
+// chain (four dependent additions) overlaps with the next terms. Lane l of
+// accumulator a handles i = first + a * W + l, then steps by 2 * W. Every
+// index is exact in a double up to 2^53.
+
+#ifdef SERIES_X86
+
+__attribute__((target("sse2"))) static void
+range_sse2(long long first, long long last, KahanSum *k) {
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d step = _mm_set1_pd(4.0);
+  __m128d d0 = _mm_add_pd(_mm_set1_pd((double)first), _mm_set_pd(1, 0));
+  __m128d d1 = _mm_add_pd(d0, _mm_set1_pd(2.0));
+  __m128d s0 = _mm_setzero_pd(), c0 = s0, s1 = s0, c1 = s0;
+
+  long long i = first;
+  for (; i + 3 <= last; i += 4) {
+    __m128d t0 = _mm_div_pd(one, _mm_mul_pd(d0, _mm_add_pd(d0, one)));
+    __m128d t1 = _mm_div_pd(one, _mm_mul_pd(d1, _mm_add_pd(d1, one)));
+    __m128d y0 = _mm_sub_pd(t0, c0), u0 = _mm_add_pd(s0, y0);
+    __m128d y1 = _mm_sub_pd(t1, c1), u1 = _mm_add_pd(s1, y1);
+    c0 = _mm_sub_pd(_mm_sub_pd(u0, s0), y0);
+    c1 = _mm_sub_pd(_mm_sub_pd(u1, s1), y1);
+    s0 = u0;
+    s1 = u1;
+    d0 = _mm_add_pd(d0, step);
+    d1 = _mm_add_pd(d1, step);
+  }
+
+  double sum[4], comp[4];
+  _mm_storeu_pd(sum, s0);
+  _mm_storeu_pd(sum + 2, s1);
+  _mm_storeu_pd(comp, c0);
+  _mm_storeu_pd(comp + 2, c1);
+  kahan_add_lanes(k, sum, comp, 4);
+  range_scalar(i, last, k);
+}
+
+__attribute__((target("avx"))) static void
+range_avx(long long first, long long last, KahanSum *k) {
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d step = _mm256_set1_pd(8.0);
+  __m256d d0 =
+      _mm256_add_pd(_mm256_set1_pd((double)first), _mm256_set_pd(3, 2, 1, 0));
+  __m256d d1 = _mm256_add_pd(d0, _mm256_set1_pd(4.0));
+  __m256d s0 = _mm256_setzero_pd(), c0 = s0, s1 = s0, c1 = s0;
+
+  long long i = first;
+  for (; i + 7 <= last; i += 8) {
+    __m256d t0 = _mm256_div_pd(one, _mm256_mul_pd(d0, _mm256_add_pd(d0, one)));
+    __m256d t1 = _mm256_div_pd(one, _mm256_mul_pd(d1, _mm256_add_pd(d1, one)));
+    __m256d y0 = _mm256_sub_pd(t0, c0), u0 = _mm256_add_pd(s0, y0);
+    __m256d y1 = _mm256_sub_pd(t1, c1), u1 = _mm256_add_pd(s1, y1);
+    c0 = _mm256_sub_pd(_mm256_sub_pd(u0, s0), y0);
+    c1 = _mm256_sub_pd(_mm256_sub_pd(u1, s1), y1);
+    s0 = u0;
+    s1 = u1;
+    d0 = _mm256_add_pd(d0, step);
+    d1 = _mm256_add_pd(d1, step);
+  }
+
+  double sum[8], comp[8];
+  _mm256_storeu_pd(sum, s0);
+  _mm256_storeu_pd(sum + 4, s1);
+  _mm256_storeu_pd(comp, c0);
+  _mm256_storeu_pd(comp + 4, c1);
+  kahan_add_lanes(k, sum, comp, 8);
+  range_scalar(i, last, k);
+}
+
+// Division is the bottleneck of the other kernels. Here 1 / x comes from the
+// 14-bit rcp14 estimate and two Newton steps r += r (1 - x r), which
+// double the correct bits each (14 -> 28 -> 56), all on the FMA ports.
+// x = d * d + d is formed with one rounding.
+__attribute__((target("avx512f"))) static void
+range_avx512(long long first, long long last, KahanSum *k) {
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d step = _mm512_set1_pd(16.0);
+  __m512d d0 = _mm512_add_pd(_mm512_set1_pd((double)first),
+                             _mm512_set_pd(7, 6, 5, 4, 3, 2, 1, 0));
+  __m512d d1 = _mm512_add_pd(d0, _mm512_set1_pd(8.0));
+  __m512d s0 = _mm512_setzero_pd(), c0 = s0, s1 = s0, c1 = s0;
+
+  long long i = first;
+  for (; i + 15 <= last; i += 16) {
+    __m512d x0 = _mm512_fmadd_pd(d0, d0, d0);
+    __m512d x1 = _mm512_fmadd_pd(d1, d1, d1);
+    __m512d t0 = _mm512_rcp14_pd(x0);
+    __m512d t1 = _mm512_rcp14_pd(x1);
+    t0 = _mm512_fmadd_pd(t0, _mm512_fnmadd_pd(x0, t0, one), t0);
+    t1 = _mm512_fmadd_pd(t1, _mm512_fnmadd_pd(x1, t1, one), t1);
+    t0 = _mm512_fmadd_pd(t0, _mm512_fnmadd_pd(x0, t0, one), t0);
+    t1 = _mm512_fmadd_pd(t1, _mm512_fnmadd_pd(x1, t1, one), t1);
+
+    __m512d y0 = _mm512_sub_pd(t0, c0), u0 = _mm512_add_pd(s0, y0);
+    __m512d y1 = _mm512_sub_pd(t1, c1), u1 = _mm512_add_pd(s1, y1);
+    c0 = _mm512_sub_pd(_mm512_sub_pd(u0, s0), y0);
+    c1 = _mm512_sub_pd(_mm512_sub_pd(u1, s1), y1);
+    s0 = u0;
+    s1 = u1;
+    d0 = _mm512_add_pd(d0, step);
+    d1 = _mm512_add_pd(d1, step);
+  }
+
+  double sum[16], comp[16];
+  _mm512_storeu_pd(sum, s0);
+  _mm512_storeu_pd(sum + 8, s1);
+  _mm512_storeu_pd(comp, c0);
+  _mm512_storeu_pd(comp + 8, c1);
+  kahan_add_lanes(k, sum, comp, 16);
+  range_scalar(i, last, k);
+}
+
+#endif
+
+#ifdef SERIES_NEON
+
+static void range_neon(long long first, long long last, KahanSum *k) {
+  const float64x2_t one = vdupq_n_f64(1.0);
+  const float64x2_t step = vdupq_n_f64(4.0);
+  const double lanes[2] = {0, 1};
+  float64x2_t d0 = vaddq_f64(vdupq_n_f64((double)first), vld1q_f64(lanes));
+  float64x2_t d1 = vaddq_f64(d0, vdupq_n_f64(2.0));
+  float64x2_t s0 = vdupq_n_f64(0), c0 = s0, s1 = s0, c1 = s0;
+
+  long long i = first;
+  for (; i + 3 <= last; i += 4) {
+    float64x2_t t0 = vdivq_f64(one, vmulq_f64(d0, vaddq_f64(d0, one)));
+    float64x2_t t1 = vdivq_f64(one, vmulq_f64(d1, vaddq_f64(d1, one)));
+    float64x2_t y0 = vsubq_f64(t0, c0), u0 = vaddq_f64(s0, y0);
+    float64x2_t y1 = vsubq_f64(t1, c1), u1 = vaddq_f64(s1, y1);
+    c0 = vsubq_f64(vsubq_f64(u0, s0), y0);
+    c1 = vsubq_f64(vsubq_f64(u1, s1), y1);
+    s0 = u0;
+    s1 = u1;
+    d0 = vaddq_f64(d0, step);
+    d1 = vaddq_f64(d1, step);
+  }
+
+  double sum[4], comp[4];
+  vst1q_f64(sum, s0);
+  vst1q_f64(sum + 2, s1);
+  vst1q_f64(comp, c0);
+  vst1q_f64(comp + 2, c1);
+  kahan_add_lanes(k, sum, comp, 4);
+  range_scalar(i, last, k);
+}
+
+#endif
+
+static series_range_fn series_kernel = NULL;
+static const char *series_kernel_name = NULL;
+
+// Keep the candidate if nothing is forced or if it is the forced one
+static int series_pick(const char *force, const char *name) {
+  return force == NULL || strcmp(force, name) == 0;
+}
+
+void series_simd_init(void) {
+  if (series_kernel != NULL)
+    return;
+
+  const char *force = getenv("SERIES_SIMD");
+  if (force != NULL && force[0] == '\0')
+    force = NULL;
+  series_range_fn kernel = NULL;
+  const char *name = NULL;
+
+#ifdef SERIES_X86
+  __builtin_cpu_init();
+  if (!kernel && __builtin_cpu_supports("avx512f") &&
+      series_pick(force, "avx512")) {
+    kernel = range_avx512;
+    name = "avx512";
+  }
+  if (!kernel && __builtin_cpu_supports("avx") && series_pick(force, "avx")) {
+    kernel = range_avx;
+    name = "avx";
+  }
+  if (!kernel && __builtin_cpu_supports("sse2") &&
+      series_pick(force, "sse2")) {
+    kernel = range_sse2;
+    name = "sse2";
+  }
+#endif
+
+#ifdef SERIES_NEON
+  if (!kernel && series_pick(force, "neon")) {
+    kernel = range_neon;
+    name = "neon";
+  }
+#endif
+
+  if (!kernel) {
+    if (force != NULL && strcmp(force, "scalar") != 0)
+      fprintf(stderr, "Warning: SERIES_SIMD=%s not available, using scalar\n",
+              force);
+    kernel = range_scalar;
+    name = "scalar";
+  }
+
+  series_kernel_name = name;
+  series_kernel = kernel;
+}
+
+const char *series_simd_kernel(void) {
+  series_simd_init();
+  return series_kernel_name;
+}
+
+double series_simd_range(long long first, long long last) {
+  series_simd_init();
+
+  KahanSum k = {0, 0};
+  if (first <= last)
+    series_kernel(first, last, &k);
+  return k.sum - k.comp;
+}
+
+double simd_series_sum(long long n) { return series_simd_range(1, n); }
+
+double omp_simd_series_range(long long first, long long last,
+                             int num_threads) {
+  series_simd_init();
+  if (first > last)
+    return 0.0;
+
+  KahanSum *partial = calloc(num_threads, sizeof(KahanSum));
+  int nb = num_threads;
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+#pragma omp single
+    nb = omp_get_num_threads();
+
+    long long count = last - first + 1;
+    long long chunk = (count + nb - 1) / nb;
+    long long lo = first + t * chunk;
+    long long hi = lo + chunk - 1 < last ? lo + chunk - 1 : last;
+    if (lo <= hi)
+      series_kernel(lo, hi, &partial[t]);
+  }
+
+  KahanSum k = {0, 0};
+  for (int t = 0; t < nb; t++) {
+    kahan_add(&k, partial[t].sum);
+    kahan_add(&k, -partial[t].comp);
+  }
+
+  free(partial);
+  return k.sum - k.comp;
+}
+
+double omp_simd_series_sum(long long n, int num_threads) {
+  return omp_simd_series_range(1, n, num_threads);
+}
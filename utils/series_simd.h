@@ -0,0 +1,25 @@
+#ifndef SERIES_SIMD_H
+#define SERIES_SIMD_H
+
+// Vectorized, compensated evaluation of the ex1 series 1 / (i (i + 1)).
+// Every lane keeps its own Kahan sum, so the rounding error stays at a few
+// ulps of the result whatever the number of terms. The kernel (avx512, avx,
+// sse2, neon or scalar) is picked once from cpuid; the SERIES_SIMD
+// environment variable forces one of them by name.
+
+void series_simd_init(void);
+
+const char *series_simd_kernel(void);
+
+// Compensated sum of the terms first .. last (1 <= first, inclusive)
+double series_simd_range(long long first, long long last);
+
+double simd_series_sum(long long n);
+
+// Contiguous block of terms per thread, the partial sums are combined in
+// thread order with compensation
+double omp_simd_series_range(long long first, long long last, int num_threads);
+
+double omp_simd_series_sum(long long n, int num_threads);
+
+#endif
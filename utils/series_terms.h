@@ -0,0 +1,24 @@
+#ifndef SERIES_TERMS_H
+#define SERIES_TERMS_H
+
+// Terms for series_engine.h. Each one comes as a function of the index and
+// of the same index already converted to double (exact up to 2^53).
+
+// sum 1 / (i (i + 1)) = 1, the ex1 series
+static inline double ex1_term(double d) { return 1.0 / (d * (d + 1)); }
+
+// sum 1 / i^2 = pi^2 / 6
+static inline double basel_term(double d) { return 1.0 / (d * d); }
+
+// Per term: one multiplication, one division and one addition to accumulate
+#define BASEL_OPS 3
+
+// sum (-1)^(i + 1) / i = ln 2
+static inline double alt_harmonic_term(long long i, double d) {
+  return (i & 1 ? 1.0 : -1.0) / d;
+}
+
+// Per term: one division and one addition to accumulate (the sign is a select)
+#define ALT_HARMONIC_OPS 2
+
+#endif
@@ -0,0 +1,520 @@
+#include "solver.h"
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// One cache line per thread for the partial dot products
+#define SOLVER_PAD 8
+
+static void solver_check(TridiagMatrix *A, int n, int need_diagonal) {
+  if (n <= 1 || A->n != n) {
+    fprintf(stderr, "Error: invalid size n=%d for matrix of size %d\n", n,
+            A->n);
+    exit(1);
+  }
+
+  if (need_diagonal) {
+    for (int i = 0; i < n; i++) {
+      if (A->main[i] == 0) {
+        fprintf(stderr, "Error: zero diagonal entry at row %d\n", i);
+        exit(1);
+      }
+    }
+  }
+}
+
+static double *solver_alloc(int n) {
+  double *v = malloc(n * sizeof(double));
+  if (v == NULL) {
+    fprintf(stderr, "Error: Could not allocate vector of size %d\n", n);
+    exit(1);
+  }
+  return v;
+}
+
+// Rows [lo, hi) of the calling thread, split like schedule(static)
+static void thread_rows(int n, int *lo, int *hi) {
+  int nb = omp_get_num_threads();
+  int t = omp_get_thread_num();
+  int q = n / nb;
+  int r = n % nb;
+  *lo = t * q + (t < r ? t : r);
+  *hi = *lo + q + (t < r ? 1 : 0);
+}
+
+// Partial sums of the team added in thread order, the same on every thread
+static double team_sum(const double *partial, int slot) {
+  double total = 0;
+  for (int t = 0; t < omp_get_num_threads(); t++)
+    total += partial[t * SOLVER_PAD + slot];
+  return total;
+}
+
+// (A v)_i
+static inline double row_product(const TridiagMatrix *A, const double *v,
+                                 int i, int n) {
+  double s = A->main[i] * v[i];
+  if (i > 0)
+    s += A->lower[i - 1] * v[i - 1];
+  if (i < n - 1)
+    s += A->upper[i] * v[i + 1];
+  return s;
+}
+
+static double relative(double rr, double bb) {
+  return sqrt(bb > 0 ? rr / bb : rr);
+}
+
+// ################################################################################
+// Conjugate gradient
+// ################################################################################
+
+SolverStats cg_solve(TridiagMatrix *A, const double *b, double *x, int n,
+                     double tol, int max_iter, int num_threads) {
+  solver_check(A, n, 0);
+
+  double *r = solver_alloc(n);
+  double *p0 = solver_alloc(n);
+  double *p1 = solver_alloc(n);
+  double *q = solver_alloc(n);
+  double *partial = calloc(2 * num_threads * SOLVER_PAD, sizeof(double));
+  SolverStats stats = {0, 0};
+
+  const int *L = A->lower;
+  const int *M = A->main;
+  const int *U = A->upper;
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    int lo, hi;
+    thread_rows(n, &lo, &hi);
+    int t = omp_get_thread_num();
+    // Pass 1 reduces into part_a, pass 2 into part_b: a slot is only
+    // written again once every thread has gone through the barrier that
+    // follows its last read
+    double *part_a = partial + t * SOLVER_PAD;
+    double *part_b = partial + (num_threads + t) * SOLVER_PAD;
+
+    // r = b - A x, p = 0 (also the first touch of the work vectors)
+    double rr_loc = 0, bb_loc = 0;
+    for (int i = lo; i < hi; i++) {
+      r[i] = b[i] - row_product(A, x, i, n);
+      p0[i] = 0;
+      rr_loc += r[i] * r[i];
+      bb_loc += b[i] * b[i];
+    }
+    part_b[0] = rr_loc;
+    part_b[1] = bb_loc;
+#pragma omp barrier
+    double rr = team_sum(partial + num_threads * SOLVER_PAD, 0);
+    double bb = team_sum(partial + num_threads * SOLVER_PAD, 1);
+    double target = tol * tol * (bb > 0 ? bb : 1);
+
+    double beta = 0;
+    double *p = p0;
+    double *pn = p1;
+    int it = 0;
+    while (it < max_iter && rr > target) {
+      // Pass 1: pn = r + beta p and q = A pn, with pn formed on the fly from
+      // r and p (no dependency on the rows other threads are writing)
+      double pq_loc = 0;
+      if (lo < hi) {
+        double wm = lo > 0 ? r[lo - 1] + beta * p[lo - 1] : 0;
+        double w0 = r[lo] + beta * p[lo];
+        for (int i = lo; i < hi; i++) {
+          double wp = i < n - 1 ? r[i + 1] + beta * p[i + 1] : 0;
+          double qi = M[i] * w0;
+          if (i > 0)
+            qi += L[i - 1] * wm;
+          if (i < n - 1)
+            qi += U[i] * wp;
+          pn[i] = w0;
+          q[i] = qi;
+          pq_loc += w0 * qi;
+          wm = w0;
+          w0 = wp;
+        }
+      }
+      part_a[0] = pq_loc;
+#pragma omp barrier
+      double alpha = rr / team_sum(partial, 0);
+
+      // Pass 2: x += alpha pn, r -= alpha q, r.r
+      rr_loc = 0;
+      for (int i = lo; i < hi; i++) {
+        x[i] += alpha * pn[i];
+        r[i] -= alpha * q[i];
+        rr_loc += r[i] * r[i];
+      }
+      part_b[0] = rr_loc;
+#pragma omp barrier
+      double rr_new = team_sum(partial + num_threads * SOLVER_PAD, 0);
+
+      beta = rr_new / rr;
+      rr = rr_new;
+      double *tmp = p;
+      p = pn;
+      pn = tmp;
+      it++;
+    }
+
+#pragma omp master
+    {
+      stats.iterations = it;
+      stats.residual = relative(rr, bb);
+    }
+  }
+
+  free(r);
+  free(p0);
+  free(p1);
+  free(q);
+  free(partial);
+  return stats;
+}
+
+// ################################################################################
+// Jacobi
+// ################################################################################
+
+SolverStats jacobi_solve(TridiagMatrix *A, const double *b, double *x, int n,
+                         double tol, int max_iter, int num_threads) {
+  solver_check(A, n, 1);
+
+  double *work = solver_alloc(n);
+  double *partial = calloc(2 * num_threads * SOLVER_PAD, sizeof(double));
+  SolverStats stats = {0, 0};
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    int lo, hi;
+    thread_rows(n, &lo, &hi);
+    int t = omp_get_thread_num();
+
+    double bb_loc = 0;
+    for (int i = lo; i < hi; i++)
+      bb_loc += b[i] * b[i];
+    partial[t * SOLVER_PAD + 1] = bb_loc;
+#pragma omp barrier
+    double bb = team_sum(partial, 1);
+    double target = tol * tol * (bb > 0 ? bb : 1);
+
+    double *cur = x;
+    double *next = work;
+    double rr = 0;
+    int it = 0;
+    for (;;) {
+      // Residual of cur and the update in the same pass; the two slots
+      // alternate so a slot is not overwritten while still being read
+      int slot = (it % 2) * num_threads;
+      double rr_loc = 0;
+      for (int i = lo; i < hi; i++) {
+        double ri = b[i] - row_product(A, cur, i, n);
+        next[i] = cur[i] + ri / A->main[i];
+        rr_loc += ri * ri;
+      }
+      partial[(slot + t) * SOLVER_PAD] = rr_loc;
+#pragma omp barrier
+      rr = team_sum(partial + slot * SOLVER_PAD, 0);
+
+      // cur already meets the tolerance: the update just computed is dropped
+      if (rr <= target || it == max_iter)
+        break;
+
+      double *tmp = cur;
+      cur = next;
+      next = tmp;
+      it++;
+    }
+
+    // The caller's x must hold the result
+    if (cur != x) {
+      for (int i = lo; i < hi; i++)
+        x[i] = cur[i];
+    }
+
+#pragma omp master
+    {
+      stats.iterations = it;
+      stats.residual = relative(rr, bb);
+    }
+  }
+
+  free(work);
+  free(partial);
+  return stats;
+}
+
+// ################################################################################
+// Red-black Gauss-Seidel
+// ################################################################################
+
+SolverStats gauss_seidel_solve(TridiagMatrix *A, const double *b, double *x,
+                               int n, double tol, int max_iter,
+                               int num_threads) {
+  solver_check(A, n, 1);
+
+  double *prev = solver_alloc(n / 2 + 1);
+  double *partial = calloc(2 * num_threads * SOLVER_PAD, sizeof(double));
+  SolverStats stats = {0, 0};
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    int lo, hi;
+    thread_rows(n, &lo, &hi);
+    int t = omp_get_thread_num();
+
+    // b.b and the residual of the initial guess (all rows)
+    double bb_loc = 0, rr_loc = 0;
+    for (int i = lo; i < hi; i++) {
+      double ri = b[i] - row_product(A, x, i, n);
+      bb_loc += b[i] * b[i];
+      rr_loc += ri * ri;
+    }
+    partial[t * SOLVER_PAD + 1] = bb_loc;
+    partial[t * SOLVER_PAD + 2] = rr_loc;
+#pragma omp barrier
+    double bb = team_sum(partial, 1);
+    double rr = team_sum(partial, 2);
+    double target = tol * tol * (bb > 0 ? bb : 1);
+
+    int it = 0;
+    for (;;) {
+      // Even rows only read odd rows, so they can all be solved at once.
+      // Their residual before the update is the whole residual of x once an
+      // iteration is done (the odd rows were then solved exactly); the old
+      // values are kept to return x itself when it meets the tolerance.
+      int slot = (it % 2) * num_threads;
+      rr_loc = 0;
+      for (int i = lo + (lo & 1); i < hi; i += 2) {
+        double ri = b[i] - row_product(A, x, i, n);
+        prev[i / 2] = x[i];
+        x[i] += ri / A->main[i];
+        rr_loc += ri * ri;
+      }
+      partial[(slot + t) * SOLVER_PAD] = rr_loc;
+#pragma omp barrier
+      if (it > 0)
+        rr = team_sum(partial + slot * SOLVER_PAD, 0);
+
+      if (rr <= target || it == max_iter) {
+        for (int i = lo + (lo & 1); i < hi; i += 2)
+          x[i] = prev[i / 2];
+        break;
+      }
+
+      for (int i = lo + !(lo & 1); i < hi; i += 2)
+        x[i] += (b[i] - row_product(A, x, i, n)) / A->main[i];
+#pragma omp barrier
+      it++;
+    }
+
+#pragma omp master
+    {
+      stats.iterations = it;
+      stats.residual = relative(rr, bb);
+    }
+  }
+
+  free(prev);
+  free(partial);
+  return stats;
+}
+
+// ################################################################################
+// Direct solvers
+// ################################################################################
+
+int spike_block(const int *lower, const int *main, const int *upper, int m,
+                const double *b, double left, double right, double *cp,
+                double *y, double *v, double *w) {
+  // Forward elimination for the three right-hand sides b, left e_0 and
+  // right e_{m-1} (the last one is zero until the last row)
+  double den = main[0];
+  if (den == 0)
+    return 0;
+  cp[0] = m > 1 ? upper[0] / den : 0;
+  y[0] = b[0] / den;
+  if (v)
+    v[0] = left / den;
+
+  for (int i = 1; i < m; i++) {
+    double a = lower[i - 1];
+    den = main[i] - a * cp[i - 1];
+    if (den == 0)
+      return 0;
+    cp[i] = i < m - 1 ? upper[i] / den : 0;
+    y[i] = (b[i] - a * y[i - 1]) / den;
+    if (v)
+      v[i] = -a * v[i - 1] / den;
+  }
+
+  // Back substitution
+  if (w)
+    w[m - 1] = right / den;
+  for (int i = m - 2; i >= 0; i--) {
+    y[i] -= cp[i] * y[i + 1];
+    if (v)
+      v[i] -= cp[i] * v[i + 1];
+    if (w)
+      w[i] = -cp[i] * w[i + 1];
+  }
+
+  return 1;
+}
+
+void spike_reduced_solve(const double *coef, double *rhs, int p) {
+  // Unknowns f_0, l_0, f_1, l_1, ... (first and last of each block):
+  //   f_k + v_first l_{k-1} + w_first f_{k+1} = y_first
+  //   l_k + v_last  l_{k-1} + w_last  f_{k+1} = y_last
+  // Row r keeps columns r - 2 .. r + 2 in band[5 r ..]
+  int N = 2 * p;
+  double *band = calloc(5 * N, sizeof(double));
+#define BAND(r, c) band[5 * (r) + 2 + (c) - (r)]
+  for (int k = 0; k < p; k++) {
+    const double *ck = coef + 4 * k;
+    BAND(2 * k, 2 * k) = 1;
+    BAND(2 * k + 1, 2 * k + 1) = 1;
+    if (k > 0) {
+      BAND(2 * k, 2 * k - 1) = ck[0];
+      BAND(2 * k + 1, 2 * k - 1) = ck[2];
+    }
+    if (k < p - 1) {
+      BAND(2 * k, 2 * k + 2) = ck[1];
+      BAND(2 * k + 1, 2 * k + 2) = ck[3];
+    }
+  }
+
+  // Banded Gaussian elimination without pivoting, then back substitution
+  for (int k = 0; k < N; k++) {
+    for (int r = k + 1; r <= k + 2 && r < N; r++) {
+      double f = BAND(r, k) / BAND(k, k);
+      if (f == 0)
+        continue;
+      for (int c = k; c <= k + 2 && c < N; c++)
+        BAND(r, c) -= f * BAND(k, c);
+      rhs[r] -= f * rhs[k];
+    }
+  }
+  for (int k = N - 1; k >= 0; k--) {
+    double s = rhs[k];
+    for (int c = k + 1; c <= k + 2 && c < N; c++)
+      s -= BAND(k, c) * rhs[c];
+    rhs[k] = s / BAND(k, k);
+  }
+#undef BAND
+
+  free(band);
+}
+
+static void zero_pivot(void) {
+  fprintf(stderr, "Error: zero pivot in the tridiagonal solve\n");
+  exit(1);
+}
+
+void thomas_solve(TridiagMatrix *A, const double *b, double *x, int n) {
+  solver_check(A, n, 0);
+
+  double *cp = solver_alloc(n);
+  if (!spike_block(A->lower, A->main, A->upper, n, b, 0, 0, cp, x, NULL,
+                   NULL))
+    zero_pivot();
+  free(cp);
+}
+
+void spike_solve(TridiagMatrix *A, const double *b, double *x, int n,
+                 int num_threads) {
+  solver_check(A, n, 0);
+
+  // Every block needs a distinct first and last row
+  if (num_threads > n / 2)
+    num_threads = n / 2;
+
+  double *cp = solver_alloc(n);
+  double *v = solver_alloc(n);
+  double *w = solver_alloc(n);
+  double *coef = malloc(4 * num_threads * sizeof(double));
+  double *rhs = malloc(2 * num_threads * sizeof(double));
+  int failed = 0;
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    int lo, hi;
+    thread_rows(n, &lo, &hi);
+    int t = omp_get_thread_num();
+    int nb = omp_get_num_threads();
+    int m = hi - lo;
+
+    // Block of the thread, coupled to x[lo - 1] and x[hi]
+    double left = lo > 0 ? A->lower[lo - 1] : 0;
+    double right = hi < n ? A->upper[hi - 1] : 0;
+    if (!spike_block(A->lower + lo, A->main + lo, A->upper + lo, m, b + lo,
+                     left, right, cp + lo, x + lo, v + lo, w + lo)) {
+#pragma omp atomic write
+      failed = 1;
+    }
+
+    coef[4 * t] = v[lo];
+    coef[4 * t + 1] = w[lo];
+    coef[4 * t + 2] = v[hi - 1];
+    coef[4 * t + 3] = w[hi - 1];
+    rhs[2 * t] = x[lo];
+    rhs[2 * t + 1] = x[hi - 1];
+#pragma omp barrier
+
+#pragma omp single
+    if (!failed)
+      spike_reduced_solve(coef, rhs, nb);
+
+    // x = y - v x_left - w x_right with the interface values
+    double xl = t > 0 ? rhs[2 * t - 1] : 0;
+    double xr = t < nb - 1 ? rhs[2 * t + 2] : 0;
+    for (int i = lo; i < hi; i++)
+      x[i] -= v[i] * xl + w[i] * xr;
+  }
+
+  if (failed)
+    zero_pivot();
+
+  free(cp);
+  free(v);
+  free(w);
+  free(coef);
+  free(rhs);
+}
+
+// ################################################################################
+// Checks and inputs
+// ################################################################################
+
+double tridiag_residual_norm(TridiagMatrix *A, const double *b,
+                             const double *x, int n, int num_threads) {
+  double rr = 0, bb = 0;
+
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for reduction(+ : rr, bb) schedule(static)
+  for (int i = 0; i < n; i++) {
+    double ri = b[i] - row_product(A, x, i, n);
+    rr += ri * ri;
+    bb += b[i] * b[i];
+  }
+
+  return relative(rr, bb);
+}
+
+void fill_rhs(double *b, int count, long long first) {
+  uint64_t stream = rng_stream(get_seed(), RNG_STREAM_VEC);
+
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < count; i++)
+    b[i] = rng_value(stream, first + i);
+}
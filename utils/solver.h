@@ -0,0 +1,73 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "utils.h"
+
+// Iterative solvers for A x = b on the three-diagonal storage (integer
+// matrix, double vectors). Each iteration fuses the product with the dot
+// products and vector updates it needs, and the whole solve runs in one
+// parallel region where every thread keeps the same rows (the split of
+// schedule(static)), so the vectors stay distributed between iterations.
+//
+// x holds the initial guess and receives the solution. The solve stops when
+// ||b - A x|| <= tol ||b|| or after max_iter iterations.
+
+typedef struct {
+  int iterations;
+  double residual; // ||b - A x|| / ||b|| as tracked by the solver
+} SolverStats;
+
+// Conjugate gradient, A symmetric positive definite. Two passes per
+// iteration: p = r + beta p, q = A p and p.q; then x += alpha p,
+// r -= alpha q and r.r.
+SolverStats cg_solve(TridiagMatrix *A, const double *b, double *x, int n,
+                     double tol, int max_iter, int num_threads);
+
+// Jacobi, one pass per iteration: the residual of the current iterate and
+// the update x += r / diag(A). Needs a non-zero diagonal.
+SolverStats jacobi_solve(TridiagMatrix *A, const double *b, double *x, int n,
+                         double tol, int max_iter, int num_threads);
+
+// Red-black Gauss-Seidel: even rows, then odd rows, each sweep in place and
+// parallel. The residual is taken during the even sweep, before the update:
+// the odd rows having just been solved, it is the full residual of x. The
+// stopping test and the reported residual use it, like Jacobi.
+SolverStats gauss_seidel_solve(TridiagMatrix *A, const double *b, double *x,
+                               int n, double tol, int max_iter,
+                               int num_threads);
+
+// Direct solvers, without pivoting (fine for diagonally dominant matrices,
+// a zero pivot is an error).
+
+// Thomas algorithm, the sequential baseline
+void thomas_solve(TridiagMatrix *A, const double *b, double *x, int n);
+
+// SPIKE-style partitioning: each thread runs Thomas on its block of rows for
+// b and for the two columns coupling it to its neighbours (the spikes v and
+// w), so that x = y - v x_left - w x_right on the block. The first and last
+// unknowns of all blocks form a pentadiagonal system of size 2 * threads,
+// solved on one thread, then every block is finished in parallel.
+void spike_solve(TridiagMatrix *A, const double *b, double *x, int n,
+                 int num_threads);
+
+// Block of SPIKE on m rows: lower[i] = A_{i+1,i} and upper[i] = A_{i,i+1}
+// (m - 1 entries each), left and right the coefficients of x_left in the
+// first row and of x_right in the last one. Writes y and, when not NULL, the
+// spikes v and w; cp is m entries of scratch. Returns 0 on a zero pivot.
+int spike_block(const int *lower, const int *main, const int *upper, int m,
+                const double *b, double left, double right, double *cp,
+                double *y, double *v, double *w);
+
+// Interface system of SPIKE for p blocks: block k gives coef[4k ..] =
+// v_first, w_first, v_last, w_last and rhs[2k ..] = y_first, y_last. On
+// return rhs holds the first and last unknown of every block.
+void spike_reduced_solve(const double *coef, double *rhs, int p);
+
+// ||b - A x|| / ||b||, computed from scratch
+double tridiag_residual_norm(TridiagMatrix *A, const double *b,
+                             const double *x, int n, int num_threads);
+
+// b[i] = entry first + i of the vector stream, as double
+void fill_rhs(double *b, int count, long long first);
+
+#endif
@@ -0,0 +1,361 @@
+#include "solver_mpi.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+DistTridiagMatrix *random_spd_tridiagonal_dist(int n, MPI_Comm comm) {
+  DistTridiagMatrix *A = malloc(sizeof(DistTridiagMatrix));
+  MPI_Comm_rank(comm, &A->rank);
+  MPI_Comm_size(comm, &A->size);
+
+  if (n < 2 || n < A->size) {
+    if (A->rank == 0)
+      fprintf(stderr, "Error: need n >= 2 and at least one row per rank\n");
+    MPI_Abort(comm, 1);
+  }
+
+  int remainder = n % A->size;
+  A->n = n;
+  A->comm = comm;
+  A->local_n = n / A->size + (A->rank < remainder ? 1 : 0);
+  A->first =
+      A->rank * (n / A->size) + (A->rank < remainder ? A->rank : remainder);
+
+  A->lower = malloc(A->local_n * sizeof(int));
+  A->main = malloc(A->local_n * sizeof(int));
+  A->upper = malloc(A->local_n * sizeof(int));
+  fill_spd_tridiagonal_rows(n, A->first, A->local_n, A->lower, A->main,
+                            A->upper);
+
+  return A;
+}
+
+void free_dist_tridiagonal(DistTridiagMatrix *A) {
+  if (!A)
+    return;
+  free(A->lower);
+  free(A->main);
+  free(A->upper);
+  free(A);
+}
+
+static double *solver_alloc(int n) {
+  double *v = malloc(n * sizeof(double));
+  if (v == NULL) {
+    fprintf(stderr, "Error: Could not allocate vector of size %d\n", n);
+    exit(1);
+  }
+  return v;
+}
+
+static void check_diagonal(const DistTridiagMatrix *A) {
+  for (int i = 0; i < A->local_n; i++) {
+    if (A->main[i] == 0) {
+      fprintf(stderr, "Error: zero diagonal entry at row %d\n", A->first + i);
+      MPI_Abort(A->comm, 1);
+    }
+  }
+}
+
+// Sends first to the left neighbour and last to the right one, receives
+// theirs in *left and *right (0 at the ends of the matrix)
+static void halo(const DistTridiagMatrix *A, double first, double last,
+                 double *left, double *right) {
+  int prev = A->rank > 0 ? A->rank - 1 : MPI_PROC_NULL;
+  int next = A->rank < A->size - 1 ? A->rank + 1 : MPI_PROC_NULL;
+
+  *left = 0;
+  *right = 0;
+  MPI_Sendrecv(&first, 1, MPI_DOUBLE, prev, 0, right, 1, MPI_DOUBLE, next, 0,
+               A->comm, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(&last, 1, MPI_DOUBLE, next, 1, left, 1, MPI_DOUBLE, prev, 1,
+               A->comm, MPI_STATUS_IGNORE);
+}
+
+// (A v)_i on the local rows, left and right are the ghost values
+static inline double local_row(const DistTridiagMatrix *A, const double *v,
+                               int i, double left, double right) {
+  return A->lower[i] * (i > 0 ? v[i - 1] : left) + A->main[i] * v[i] +
+         A->upper[i] * (i < A->local_n - 1 ? v[i + 1] : right);
+}
+
+static double global_sum(const DistTridiagMatrix *A, double v) {
+  double total;
+  MPI_Allreduce(&v, &total, 1, MPI_DOUBLE, MPI_SUM, A->comm);
+  return total;
+}
+
+static double relative(double rr, double bb) {
+  return sqrt(bb > 0 ? rr / bb : rr);
+}
+
+// ################################################################################
+// Conjugate gradient
+// ################################################################################
+
+SolverStats mpi_cg_solve(DistTridiagMatrix *A, const double *b, double *x,
+                         double tol, int max_iter) {
+  int ln = A->local_n;
+  double *r = solver_alloc(ln);
+  double *p = solver_alloc(ln);
+  double *pn = solver_alloc(ln);
+  double *q = solver_alloc(ln);
+  double left, right;
+
+  // r = b - A x, p = 0, with r.r and b.b in one reduction
+  halo(A, x[0], x[ln - 1], &left, &right);
+  double loc[2] = {0, 0}, glob[2];
+  for (int i = 0; i < ln; i++) {
+    r[i] = b[i] - local_row(A, x, i, left, right);
+    p[i] = 0;
+    loc[0] += r[i] * r[i];
+    loc[1] += b[i] * b[i];
+  }
+  MPI_Allreduce(loc, glob, 2, MPI_DOUBLE, MPI_SUM, A->comm);
+  double rr = glob[0];
+  double bb = glob[1];
+  double target = tol * tol * (bb > 0 ? bb : 1);
+
+  double beta = 0;
+  int it = 0;
+  while (it < max_iter && rr > target) {
+    // Pass 1: pn = r + beta p, q = A pn and pn.q; only the two boundary
+    // values of pn cross ranks
+    halo(A, r[0] + beta * p[0], r[ln - 1] + beta * p[ln - 1], &left, &right);
+    double wm = left;
+    double w0 = r[0] + beta * p[0];
+    double pq = 0;
+    for (int i = 0; i < ln; i++) {
+      double wp = i < ln - 1 ? r[i + 1] + beta * p[i + 1] : right;
+      double qi = A->lower[i] * wm + A->main[i] * w0 + A->upper[i] * wp;
+      pn[i] = w0;
+      q[i] = qi;
+      pq += w0 * qi;
+      wm = w0;
+      w0 = wp;
+    }
+    double alpha = rr / global_sum(A, pq);
+
+    // Pass 2: x += alpha pn, r -= alpha q, r.r
+    double rr_loc = 0;
+    for (int i = 0; i < ln; i++) {
+      x[i] += alpha * pn[i];
+      r[i] -= alpha * q[i];
+      rr_loc += r[i] * r[i];
+    }
+    double rr_new = global_sum(A, rr_loc);
+
+    beta = rr_new / rr;
+    rr = rr_new;
+    double *tmp = p;
+    p = pn;
+    pn = tmp;
+    it++;
+  }
+
+  free(r);
+  free(p);
+  free(pn);
+  free(q);
+
+  SolverStats stats = {it, relative(rr, bb)};
+  return stats;
+}
+
+// ################################################################################
+// Jacobi
+// ################################################################################
+
+SolverStats mpi_jacobi_solve(DistTridiagMatrix *A, const double *b, double *x,
+                             double tol, int max_iter) {
+  check_diagonal(A);
+
+  int ln = A->local_n;
+  double *work = solver_alloc(ln);
+  double left, right;
+
+  double bb_loc = 0;
+  for (int i = 0; i < ln; i++)
+    bb_loc += b[i] * b[i];
+  double bb = global_sum(A, bb_loc);
+  double target = tol * tol * (bb > 0 ? bb : 1);
+
+  double *cur = x;
+  double *next = work;
+  double rr = 0;
+  int it = 0;
+  for (;;) {
+    // Residual of cur and the update in the same pass
+    halo(A, cur[0], cur[ln - 1], &left, &right);
+    double rr_loc = 0;
+    for (int i = 0; i < ln; i++) {
+      double ri = b[i] - local_row(A, cur, i, left, right);
+      next[i] = cur[i] + ri / A->main[i];
+      rr_loc += ri * ri;
+    }
+    rr = global_sum(A, rr_loc);
+
+    if (rr <= target || it == max_iter)
+      break;
+
+    double *tmp = cur;
+    cur = next;
+    next = tmp;
+    it++;
+  }
+
+  if (cur != x) {
+    for (int i = 0; i < ln; i++)
+      x[i] = cur[i];
+  }
+  free(work);
+
+  SolverStats stats = {it, relative(rr, bb)};
+  return stats;
+}
+
+// ################################################################################
+// Red-black Gauss-Seidel
+// ################################################################################
+
+SolverStats mpi_gauss_seidel_solve(DistTridiagMatrix *A, const double *b,
+                                   double *x, double tol, int max_iter) {
+  check_diagonal(A);
+
+  int ln = A->local_n;
+  double *prev = solver_alloc(ln / 2 + 1);
+  double left, right;
+  // Local index of the first even and of the first odd global row
+  int even = A->first & 1;
+  int odd = !even;
+
+  // b.b and the residual of the initial guess (all rows)
+  halo(A, x[0], x[ln - 1], &left, &right);
+  double loc[2] = {0, 0}, glob[2];
+  for (int i = 0; i < ln; i++) {
+    double ri = b[i] - local_row(A, x, i, left, right);
+    loc[0] += ri * ri;
+    loc[1] += b[i] * b[i];
+  }
+  MPI_Allreduce(loc, glob, 2, MPI_DOUBLE, MPI_SUM, A->comm);
+  double rr = glob[0];
+  double bb = glob[1];
+  double target = tol * tol * (bb > 0 ? bb : 1);
+
+  int it = 0;
+  for (;;) {
+    // Even rows: their residual before the update is the whole residual of
+    // x once an iteration is done (the odd rows were then solved exactly)
+    halo(A, x[0], x[ln - 1], &left, &right);
+    double rr_loc = 0;
+    for (int i = even; i < ln; i += 2) {
+      double ri = b[i] - local_row(A, x, i, left, right);
+      prev[i / 2] = x[i];
+      x[i] += ri / A->main[i];
+      rr_loc += ri * ri;
+    }
+    double rr_even = global_sum(A, rr_loc);
+    if (it > 0)
+      rr = rr_even;
+
+    // x already meets the tolerance: the even update is undone
+    if (rr <= target || it == max_iter) {
+      for (int i = even; i < ln; i += 2)
+        x[i] = prev[i / 2];
+      break;
+    }
+
+    // Odd rows see the even ghosts of this iteration
+    halo(A, x[0], x[ln - 1], &left, &right);
+    for (int i = odd; i < ln; i += 2)
+      x[i] += (b[i] - local_row(A, x, i, left, right)) / A->main[i];
+    it++;
+  }
+
+  free(prev);
+
+  SolverStats stats = {it, relative(rr, bb)};
+  return stats;
+}
+
+// ################################################################################
+// SPIKE
+// ################################################################################
+
+void mpi_spike_solve(DistTridiagMatrix *A, const double *b, double *x) {
+  int ln = A->local_n;
+  if (ln < 2) {
+    fprintf(stderr, "Error: SPIKE needs at least two rows per rank\n");
+    MPI_Abort(A->comm, 1);
+  }
+
+  double *cp = solver_alloc(ln);
+  double *v = solver_alloc(ln);
+  double *w = solver_alloc(ln);
+
+  // Row-indexed slices: the block's A_{i+1,i} start at lower[1], lower[0]
+  // and upper[ln - 1] couple it to the neighbours (0 at the matrix ends)
+  if (!spike_block(A->lower + 1, A->main, A->upper, ln, b, A->lower[0],
+                   A->upper[ln - 1], cp, x, v, w)) {
+    fprintf(stderr, "Error: zero pivot in the tridiagonal solve\n");
+    MPI_Abort(A->comm, 1);
+  }
+
+  double local[6] = {v[0], w[0], v[ln - 1], w[ln - 1], x[0], x[ln - 1]};
+  double *all = NULL;
+  double *ghosts = NULL;
+  if (A->rank == 0) {
+    all = malloc(6 * A->size * sizeof(double));
+    ghosts = malloc(2 * A->size * sizeof(double));
+  }
+  MPI_Gather(local, 6, MPI_DOUBLE, all, 6, MPI_DOUBLE, 0, A->comm);
+
+  if (A->rank == 0) {
+    int p = A->size;
+    double *coef = malloc(4 * p * sizeof(double));
+    double *rhs = malloc(2 * p * sizeof(double));
+    for (int k = 0; k < p; k++) {
+      for (int j = 0; j < 4; j++)
+        coef[4 * k + j] = all[6 * k + j];
+      rhs[2 * k] = all[6 * k + 4];
+      rhs[2 * k + 1] = all[6 * k + 5];
+    }
+    spike_reduced_solve(coef, rhs, p);
+
+    // Rank k needs the last unknown of k - 1 and the first of k + 1
+    for (int k = 0; k < p; k++) {
+      ghosts[2 * k] = k > 0 ? rhs[2 * k - 1] : 0;
+      ghosts[2 * k + 1] = k < p - 1 ? rhs[2 * k + 2] : 0;
+    }
+    free(coef);
+    free(rhs);
+  }
+
+  double ghost[2];
+  MPI_Scatter(ghosts, 2, MPI_DOUBLE, ghost, 2, MPI_DOUBLE, 0, A->comm);
+
+  for (int i = 0; i < ln; i++)
+    x[i] -= v[i] * ghost[0] + w[i] * ghost[1];
+
+  free(all);
+  free(ghosts);
+  free(cp);
+  free(v);
+  free(w);
+}
+
+double mpi_residual_norm(DistTridiagMatrix *A, const double *b,
+                         const double *x) {
+  double left, right;
+  halo(A, x[0], x[A->local_n - 1], &left, &right);
+
+  double loc[2] = {0, 0}, glob[2];
+  for (int i = 0; i < A->local_n; i++) {
+    double ri = b[i] - local_row(A, x, i, left, right);
+    loc[0] += ri * ri;
+    loc[1] += b[i] * b[i];
+  }
+  MPI_Allreduce(loc, glob, 2, MPI_DOUBLE, MPI_SUM, A->comm);
+
+  return relative(glob[0], glob[1]);
+}
@@ -0,0 +1,51 @@
+#ifndef SOLVER_MPI_H
+#define SOLVER_MPI_H
+
+#include "solver.h"
+#include <mpi.h>
+
+// Block of rows of a tridiagonal matrix on one rank, row-indexed like the
+// slices of matrix_vector_mpi: lower[i] = A_{r,r-1} and upper[i] = A_{r,r+1}
+// for the global row r = first + i, 0 outside the matrix. Rows are split
+// like matrix_vector_mpi (n / size each, one more on the first n % size).
+typedef struct {
+  int n;
+  int first;
+  int local_n;
+  int *lower;
+  int *main;
+  int *upper;
+  MPI_Comm comm;
+  int rank;
+  int size;
+} DistTridiagMatrix;
+
+// Local rows of random_spd_tridiagonal_matrix(n), generated on each rank
+DistTridiagMatrix *random_spd_tridiagonal_dist(int n, MPI_Comm comm);
+
+void free_dist_tridiagonal(DistTridiagMatrix *A);
+
+// The solvers of solver.h on distributed vectors: b and x are the local
+// rows. Each product exchanges one value with each neighbour, each dot
+// product is one MPI_Allreduce, the vectors never leave their rank. The
+// stats are the same on every rank.
+SolverStats mpi_cg_solve(DistTridiagMatrix *A, const double *b, double *x,
+                         double tol, int max_iter);
+
+SolverStats mpi_jacobi_solve(DistTridiagMatrix *A, const double *b, double *x,
+                             double tol, int max_iter);
+
+// Red and black by global row parity, a halo exchange before each sweep
+SolverStats mpi_gauss_seidel_solve(DistTridiagMatrix *A, const double *b,
+                                   double *x, double tol, int max_iter);
+
+// SPIKE with one block per rank (spike_solve of solver.h): local Thomas for
+// b and the two spikes, the 6 interface values of every rank gathered and
+// solved on rank 0, then two values sent back to each rank. Needs at least
+// two rows per rank.
+void mpi_spike_solve(DistTridiagMatrix *A, const double *b, double *x);
+
+double mpi_residual_norm(DistTridiagMatrix *A, const double *b,
+                         const double *x);
+
+#endif
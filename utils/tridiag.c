@@ -0,0 +1,459 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "tridiag.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Computes rows [a, b) of a product for one storage layout:
+// out[i - out_off] = (A in)_i, with in indexed as in[j - in_off]
+typedef void (*tile_rows_fn)(const void *matrix, const int *in, int in_off,
+                             int *out, int out_off, int a, int b);
+
+static void tridiag_rows(const void *matrix, const int *in, int in_off,
+                         int *out, int out_off, int a, int b) {
+  const TridiagMatrix *A = matrix;
+  int n = A->n;
+  const int *L = A->lower;
+  const int *M = A->main;
+  const int *U = A->upper;
+
+  int i = a;
+  if (i == 0) {
+    out[-out_off] = M[0] * in[-in_off] + U[0] * in[1 - in_off];
+    i = 1;
+  }
+
+  int end = b < n - 1 ? b : n - 1;
+  for (; i < end; i++) {
+    out[i - out_off] = L[i - 1] * in[i - 1 - in_off] + M[i] * in[i - in_off] +
+                       U[i] * in[i + 1 - in_off];
+  }
+
+  if (b == n) {
+    out[n - 1 - out_off] =
+        L[n - 2] * in[n - 2 - in_off] + M[n - 1] * in[n - 1 - in_off];
+  }
+}
+
+// Row i of the packed layout lives in block i / W at lane i % W. Full blocks
+// away from the first and last row run without any bounds test.
+static void packed_rows(const void *matrix, const int *in, int in_off,
+                        int *out, int out_off, int a, int b) {
+  const PackedTridiagMatrix *P = matrix;
+  int n = P->n;
+  const int W = TRIDIAG_PACK_W;
+
+  int i = a;
+  while (i < b) {
+    const int *blk = P->data + (size_t)(i / W) * 3 * W;
+
+    if (i % W == 0 && i + W <= b && i > 0 && i + W < n) {
+      const int *l = blk;
+      const int *m = blk + W;
+      const int *u = blk + 2 * W;
+      const int *x = in + (i - in_off);
+      int *y = out + (i - out_off);
+      for (int j = 0; j < W; j++)
+        y[j] = l[j] * x[j - 1] + m[j] * x[j] + u[j] * x[j + 1];
+      i += W;
+    } else {
+      int j = i % W;
+      int v = blk[W + j] * in[i - in_off];
+      if (i > 0)
+        v += blk[j] * in[i - 1 - in_off];
+      if (i < n - 1)
+        v += blk[2 * W + j] * in[i + 1 - in_off];
+      out[i - out_off] = v;
+      i++;
+    }
+  }
+}
+
+// Push rows [lo, hi) of x through k products. Step s only needs the rows
+// within k - s of the tile, so the valid range shrinks by one on each side per
+// step. buf0 and buf1 hold hi - lo + 2k entries each.
+static void power_tile(tile_rows_fn rows, const void *A, int n, const int *x,
+                       int *y, int lo, int hi, int k, int *buf0, int *buf1) {
+  int ext_lo = lo - k > 0 ? lo - k : 0;
+
+  const int *in = x;
+  int in_off = 0;
+  int *cur = buf0;
+  int *next = buf1;
+
+  for (int s = 1; s <= k; s++) {
+    int r = k - s;
+    int a = lo - r > 0 ? lo - r : 0;
+    int b = hi + r < n ? hi + r : n;
+
+    if (s == k) {
+      rows(A, in, in_off, y, 0, a, b);
+    } else {
+      rows(A, in, in_off, cur, ext_lo, a, b);
+      in = cur;
+      in_off = ext_lo;
+      int *tmp = cur;
+      cur = next;
+      next = tmp;
+    }
+  }
+}
+
+static int *power_vector_alloc(int matrix_n, int *vec, int n, int k) {
+
+  if (n <= 1 || matrix_n != n) {
+    fprintf(stderr, "Error: invalid size n=%d for matrix of size %d\n", n,
+            matrix_n);
+    exit(1);
+  }
+
+  if (k < 0) {
+    fprintf(stderr, "Error: k must be non-negative\n");
+    exit(1);
+  }
+
+  int *result = malloc(n * sizeof(int));
+  if (result == NULL) {
+    fprintf(stderr, "Error: Could not allocate result vector\n");
+    exit(1);
+  }
+
+  if (k == 0)
+    memcpy(result, vec, n * sizeof(int));
+
+  return result;
+}
+
+static int *power_vector_seq(tile_rows_fn rows, const void *matrix,
+                             int matrix_n, int *vec, int n, int k) {
+
+  int *result = power_vector_alloc(matrix_n, vec, n, k);
+  if (k == 0)
+    return result;
+
+  int *buf0 = malloc((TRIDIAG_TILE + 2 * k) * sizeof(int));
+  int *buf1 = malloc((TRIDIAG_TILE + 2 * k) * sizeof(int));
+
+  for (int lo = 0; lo < n; lo += TRIDIAG_TILE) {
+    int hi = lo + TRIDIAG_TILE < n ? lo + TRIDIAG_TILE : n;
+    power_tile(rows, matrix, n, vec, result, lo, hi, k, buf0, buf1);
+  }
+
+  free(buf0);
+  free(buf1);
+
+  return result;
+}
+
+static int *power_vector_omp(tile_rows_fn rows, const void *matrix,
+                             int matrix_n, int *vec, int n, int k,
+                             int num_threads) {
+
+  int *result = power_vector_alloc(matrix_n, vec, n, k);
+  if (k == 0)
+    return result;
+
+  int ntiles = (n + TRIDIAG_TILE - 1) / TRIDIAG_TILE;
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    // Tiles are independent, each thread keeps its own halo buffers
+    int *buf0 = malloc((TRIDIAG_TILE + 2 * k) * sizeof(int));
+    int *buf1 = malloc((TRIDIAG_TILE + 2 * k) * sizeof(int));
+
+#pragma omp for schedule(static)
+    for (int t = 0; t < ntiles; t++) {
+      int lo = t * TRIDIAG_TILE;
+      int hi = lo + TRIDIAG_TILE < n ? lo + TRIDIAG_TILE : n;
+      power_tile(rows, matrix, n, vec, result, lo, hi, k, buf0, buf1);
+    }
+
+    free(buf0);
+    free(buf1);
+  }
+
+  return result;
+}
+
+int *sequential_matrix_opti_power_vector_multiplication(TridiagMatrix *matrix,
+                                                        int *vec, int n,
+                                                        int k) {
+  return power_vector_seq(tridiag_rows, matrix, matrix->n, vec, n, k);
+}
+
+int *omp_matrix_opti_power_vector_multiplication(TridiagMatrix *matrix,
+                                                 int *vec, int n, int k,
+                                                 int num_threads) {
+  return power_vector_omp(tridiag_rows, matrix, matrix->n, vec, n, k,
+                          num_threads);
+}
+
+// ################################################################################
+// Persistent iterations
+// ################################################################################
+
+static void iterate_check(TridiagMatrix *matrix, int n, int steps) {
+  if (n <= 1 || matrix->n != n) {
+    fprintf(stderr, "Error: invalid size n=%d for matrix of size %d\n", n,
+            matrix->n);
+    exit(1);
+  }
+
+  if (steps < 0) {
+    fprintf(stderr, "Error: the number of steps must be non-negative\n");
+    exit(1);
+  }
+}
+
+int *sequential_matrix_opti_vector_iterate(TridiagMatrix *matrix, int *x,
+                                           int *work, int n, int steps) {
+  iterate_check(matrix, n, steps);
+
+  int *in = x;
+  int *out = work;
+  for (int s = 0; s < steps; s++) {
+    tridiag_rows(matrix, in, 0, out, 0, 0, n);
+    int *tmp = in;
+    in = out;
+    out = tmp;
+  }
+
+  return in;
+}
+
+int *omp_matrix_opti_vector_iterate(TridiagMatrix *matrix, int *x, int *work,
+                                    int n, int steps, int num_threads) {
+  iterate_check(matrix, n, steps);
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    // Rows of this thread, split like schedule(static)
+    int nb = omp_get_num_threads();
+    int t = omp_get_thread_num();
+    int q = n / nb;
+    int r = n % nb;
+    int lo = t * q + (t < r ? t : r);
+    int hi = lo + q + (t < r ? 1 : 0);
+
+    int *in = x;
+    int *out = work;
+    for (int s = 0; s < steps; s++) {
+      if (lo < hi)
+        tridiag_rows(matrix, in, 0, out, 0, lo, hi);
+      int *tmp = in;
+      in = out;
+      out = tmp;
+      // Step s + 1 reads the rows of the neighbours written at step s
+#pragma omp barrier
+    }
+  }
+
+  return steps % 2 == 0 ? x : work;
+}
+
+// ################################################################################
+// Row-packed layout
+// ################################################################################
+
+PackedTridiagMatrix *pack_tridiagonal(const TridiagMatrix *A) {
+  int n = A->n;
+  const int W = TRIDIAG_PACK_W;
+
+  PackedTridiagMatrix *P = malloc(sizeof(PackedTridiagMatrix));
+  P->n = n;
+  P->nblocks = (n + W - 1) / W;
+
+  void *data = NULL;
+  if (posix_memalign(&data, 64, (size_t)P->nblocks * 3 * W * sizeof(int)) !=
+      0) {
+    fprintf(stderr, "Error: Could not allocate packed matrix of size %d\n", n);
+    exit(1);
+  }
+  P->data = data;
+
+  // Slots outside the matrix (lower of row 0, upper of row n-1, padding
+  // rows of the last block) are stored as 0
+#pragma omp parallel for schedule(static)
+  for (int b = 0; b < P->nblocks; b++) {
+    int *blk = P->data + (size_t)b * 3 * W;
+    for (int j = 0; j < W; j++) {
+      int i = b * W + j;
+      blk[j] = (i > 0 && i < n) ? A->lower[i - 1] : 0;
+      blk[W + j] = i < n ? A->main[i] : 0;
+      blk[2 * W + j] = i < n - 1 ? A->upper[i] : 0;
+    }
+  }
+
+  return P;
+}
+
+TridiagMatrix *unpack_tridiagonal(const PackedTridiagMatrix *P) {
+  int n = P->n;
+  const int W = TRIDIAG_PACK_W;
+
+  TridiagMatrix *A = malloc(sizeof(TridiagMatrix));
+  A->n = n;
+  A->lower = malloc((n - 1) * sizeof(int));
+  A->main = malloc(n * sizeof(int));
+  A->upper = malloc((n - 1) * sizeof(int));
+
+  for (int i = 0; i < n; i++) {
+    const int *blk = P->data + (size_t)(i / W) * 3 * W;
+    int j = i % W;
+    if (i > 0)
+      A->lower[i - 1] = blk[j];
+    A->main[i] = blk[W + j];
+    if (i < n - 1)
+      A->upper[i] = blk[2 * W + j];
+  }
+
+  return A;
+}
+
+void free_packed_tridiagonal(PackedTridiagMatrix *P) {
+  if (!P)
+    return;
+  free(P->data);
+  free(P);
+}
+
+int *sequential_packed_matrix_vector_multiplication(PackedTridiagMatrix *matrix,
+                                                    int *vec, int n) {
+  int *result = malloc(n * sizeof(int));
+  packed_rows(matrix, vec, 0, result, 0, 0, n);
+  return result;
+}
+
+int *omp_packed_matrix_vector_multiplication(PackedTridiagMatrix *matrix,
+                                             int *vec, int n,
+                                             int num_threads) {
+  int *result = malloc(n * sizeof(int));
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    // Contiguous range of whole blocks per thread
+    int nb = omp_get_num_threads();
+    int W = TRIDIAG_PACK_W;
+    int chunk = ((n + nb - 1) / nb + W - 1) / W * W;
+    int lo = omp_get_thread_num() * chunk;
+    int hi = lo + chunk < n ? lo + chunk : n;
+    if (lo < hi)
+      packed_rows(matrix, vec, 0, result, 0, lo, hi);
+  }
+
+  return result;
+}
+
+int *sequential_packed_matrix_power_vector_multiplication(
+    PackedTridiagMatrix *matrix, int *vec, int n, int k) {
+  return power_vector_seq(packed_rows, matrix, matrix->n, vec, n, k);
+}
+
+int *omp_packed_matrix_power_vector_multiplication(PackedTridiagMatrix *matrix,
+                                                   int *vec, int n, int k,
+                                                   int num_threads) {
+  return power_vector_omp(packed_rows, matrix, matrix->n, vec, n, k,
+                          num_threads);
+}
+
+// ################################################################################
+// y = A x, dense (naive) and three-diagonal storage
+// ################################################################################
+
+int *sequential_matrix_vector_multiplication(int **matrix, int *vec, int n) {
+
+  int *result = malloc(n * sizeof(int));
+
+  for (int i = 0; i < n; i++) {
+    int sum = 0;
+    // Since it's a tridiagonal matrix, only (i-1), i, and (i+1) elements are
+    // possibly non-zero
+    if (i > 0) {
+      sum += matrix[i][i - 1] * vec[i - 1];
+    }
+    sum += matrix[i][i] * vec[i];
+    if (i < n - 1) {
+      sum += matrix[i][i + 1] * vec[i + 1];
+    }
+    result[i] = sum;
+  }
+
+  return result;
+}
+
+int *sequential_matrix_opti_vector_multiplication(TridiagMatrix *matrix, int *vec, int n) {
+
+  int *result = malloc(n * sizeof(int));
+
+  result[0] = matrix->main[0] * vec[0] + matrix->upper[0] * vec[1];
+
+  for (int i = 1; i < n - 1; i++) {
+    result[i] = matrix->lower[i - 1] * vec[i - 1] + matrix->main[i] * vec[i] +
+                matrix->upper[i] * vec[i + 1];
+  }
+
+  result[n - 1] =
+      matrix->lower[n - 2] * vec[n - 2] + matrix->main[n - 1] * vec[n - 1];
+
+  return result;
+}
+
+int *omp_matrix_vector_multiplication(int **matrix, int *vec, int n,
+                                      int num_threads) {
+
+  int *result = malloc(n * sizeof(int));
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for
+  for (int i = 0; i < n; i++) {
+    int sum = 0;
+    // Since it's a tridiagonal matrix, only (i-1), i, and (i+1) elements are
+    // possibly non-zero
+    if (i > 0) {
+      sum += matrix[i][i - 1] * vec[i - 1];
+    }
+    sum += matrix[i][i] * vec[i];
+    if (i < n - 1) {
+      sum += matrix[i][i + 1] * vec[i + 1];
+    }
+    result[i] = sum;
+  }
+
+  return result;
+}
+
+int *omp_matrix_opti_vector_multiplication(TridiagMatrix *matrix, int *vec,
+                                           int n, int num_threads) {
+
+  int *result = malloc(n * sizeof(int));
+
+  result[0] = matrix->main[0] * vec[0] + matrix->upper[0] * vec[1];
+  result[n - 1] =
+      matrix->lower[n - 2] * vec[n - 2] + matrix->main[n - 1] * vec[n - 1];
+
+  omp_matrix_opti_vector_rows(matrix->lower, matrix->main, matrix->upper, vec,
+                              result, 1, n - 1, num_threads);
+
+  return result;
+}
+
+void omp_matrix_opti_vector_rows(const int *lower, const int *main,
+                                 const int *upper, const int *vec, int *result,
+                                 int a, int b, int num_threads) {
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel for
+  for (int i = a; i < b; i++) {
+    result[i] = lower[i - 1] * vec[i - 1] + main[i] * vec[i] +
+                upper[i] * vec[i + 1];
+  }
+}
@@ -0,0 +1,94 @@
+#ifndef TRIDIAG_H
+#define TRIDIAG_H
+
+#include "utils.h"
+
+// Compulsory bytes and integer ops per row of y = A x, for the roofline
+// report: L, M, U and x read and y written once (4 bytes each), 3
+// multiplications and 2 additions. The dense kernels also load the row
+// pointer. Every layout moves the same bytes per row.
+#define TRIDIAG_MATVEC_BYTES 20
+#define TRIDIAG_MATVEC_OPS 5
+#define TRIDIAG_DENSE_MATVEC_BYTES 28
+
+// Rows per tile for the temporally blocked kernels. A tile plus its halo
+// (diagonals and two ping-pong buffers) stays around 100 KB, i.e. in L2.
+#define TRIDIAG_TILE 4096
+
+// Rows per block of the packed layout: one 64-byte line per diagonal
+#define TRIDIAG_PACK_W 16
+
+// Tridiagonal matrix with the three diagonals interleaved by blocks of
+// TRIDIAG_PACK_W rows: block b holds lower, main and upper of rows
+// [b * W, (b + 1) * W) back to back, so a product streams one matrix array
+// instead of three. Here lower is indexed by row (A_{i, i-1}, 0 for row 0).
+typedef struct {
+  int n;
+  int nblocks;
+  int *data; // nblocks * 3 * TRIDIAG_PACK_W entries, 64-byte aligned
+} PackedTridiagMatrix;
+
+// y = A x on a dense n x n matrix (only the three diagonals are read)
+int *sequential_matrix_vector_multiplication(int **matrix, int *vec, int n);
+
+int *omp_matrix_vector_multiplication(int **matrix, int *vec, int n,
+                                      int num_threads);
+
+// y = A x on the three-diagonal storage
+int *sequential_matrix_opti_vector_multiplication(TridiagMatrix *matrix,
+                                                  int *vec, int n);
+
+int *omp_matrix_opti_vector_multiplication(TridiagMatrix *matrix, int *vec,
+                                           int n, int num_threads);
+
+// Rows [a, b) of y = A x with every row having both neighbours (0 < a and
+// b < number of rows), on raw diagonals indexed like TridiagMatrix: row i
+// reads lower[i - 1], main[i] and upper[i]. The loop of the kernel above,
+// for callers holding only a slice of A (the MPI ranks).
+void omp_matrix_opti_vector_rows(const int *lower, const int *main,
+                                 const int *upper, const int *vec, int *result,
+                                 int a, int b, int num_threads);
+
+// y = A^k x without forming A^k: x is cut into tiles that are pushed through
+// all k products while they sit in cache (overlapped tiles, each tile reads a
+// halo of k extra rows on both sides and recomputes it).
+int *sequential_matrix_opti_power_vector_multiplication(TridiagMatrix *matrix,
+                                                        int *vec, int n,
+                                                        int k);
+
+int *omp_matrix_opti_power_vector_multiplication(TridiagMatrix *matrix,
+                                                 int *vec, int n, int k,
+                                                 int num_threads);
+
+// steps successive products x <- A x inside one parallel region. x (the
+// input) and work are two ping-pong buffers of n entries; every thread owns
+// the same rows at every step (the split of schedule(static), so buffers from
+// alloc_vec_first_touch are local), only a barrier separates two steps and
+// nothing is allocated. Returns the buffer holding A^steps x: x when steps
+// is even, work otherwise.
+int *sequential_matrix_opti_vector_iterate(TridiagMatrix *matrix, int *x,
+                                           int *work, int n, int steps);
+
+int *omp_matrix_opti_vector_iterate(TridiagMatrix *matrix, int *x, int *work,
+                                    int n, int steps, int num_threads);
+
+PackedTridiagMatrix *pack_tridiagonal(const TridiagMatrix *A);
+
+TridiagMatrix *unpack_tridiagonal(const PackedTridiagMatrix *P);
+
+void free_packed_tridiagonal(PackedTridiagMatrix *P);
+
+int *sequential_packed_matrix_vector_multiplication(PackedTridiagMatrix *matrix,
+                                                    int *vec, int n);
+
+int *omp_packed_matrix_vector_multiplication(PackedTridiagMatrix *matrix,
+                                             int *vec, int n, int num_threads);
+
+int *sequential_packed_matrix_power_vector_multiplication(
+    PackedTridiagMatrix *matrix, int *vec, int n, int k);
+
+int *omp_packed_matrix_power_vector_multiplication(PackedTridiagMatrix *matrix,
+                                                   int *vec, int n, int k,
+                                                   int num_threads);
+
+#endif
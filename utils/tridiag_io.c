@@ -0,0 +1,136 @@
+#include "tridiag_io.h"
+#include <stdio.h>
+#include <string.h>
+
+#define HEADER_INTS 3
+#define HEADER_BYTES ((MPI_Offset)(HEADER_INTS * sizeof(int)))
+
+// Offset of entry i of the array starting after `before` ints of data
+static MPI_Offset data_offset(long long before, long long i) {
+  return HEADER_BYTES + (MPI_Offset)(before + i) * (MPI_Offset)sizeof(int);
+}
+
+static MPI_File open_file(const char *path, int mode, MPI_Comm comm) {
+  MPI_File file;
+  if (MPI_File_open(comm, path, mode, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+    fprintf(stderr, "Error: Could not open file %s\n", path);
+    MPI_Abort(comm, 1);
+  }
+  return file;
+}
+
+static void make_header(int header[HEADER_INTS], const char *magic, int n) {
+  memcpy(&header[0], magic, sizeof(int));
+  header[1] = TRIDIAG_FILE_VERSION;
+  header[2] = n;
+}
+
+// Every rank passes the header, only rank 0 writes it (count 0 elsewhere)
+static void write_header(MPI_File file, const char *magic, int n,
+                         MPI_Comm comm) {
+  int rank, header[HEADER_INTS];
+  MPI_Comm_rank(comm, &rank);
+  make_header(header, magic, n);
+  MPI_File_write_at_all(file, 0, header, rank == 0 ? HEADER_INTS : 0, MPI_INT,
+                        MPI_STATUS_IGNORE);
+}
+
+// ################################################################################
+// Read
+// ################################################################################
+
+int tridiag_file_size(const char *path, MPI_Comm comm) {
+  MPI_File file;
+  // The error handler of files is MPI_ERRORS_RETURN: a missing file is -1
+  if (MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) !=
+      MPI_SUCCESS)
+    return -1;
+
+  int header[HEADER_INTS], expected[HEADER_INTS];
+  MPI_File_read_at_all(file, 0, header, HEADER_INTS, MPI_INT,
+                       MPI_STATUS_IGNORE);
+  MPI_File_close(&file);
+
+  make_header(expected, "TRID", header[2]);
+  if (memcmp(header, expected, sizeof(header)) != 0 || header[2] < 2) {
+    fprintf(stderr, "Error: %s is not a tridiagonal product file\n", path);
+    MPI_Abort(comm, 1);
+  }
+  return header[2];
+}
+
+void tridiag_file_read(const char *path, int n, int first, int local_n,
+                       int *vec, int *main, int *lower, int *upper,
+                       MPI_Comm comm) {
+  MPI_File file = open_file(path, MPI_MODE_RDONLY, comm);
+  long long ln = n;
+
+  MPI_File_read_at_all(file, data_offset(0, first), vec, local_n, MPI_INT,
+                       MPI_STATUS_IGNORE);
+  MPI_File_read_at_all(file, data_offset(ln, first), main, local_n, MPI_INT,
+                       MPI_STATUS_IGNORE);
+
+  // Row r needs lower[r - 1]: the slice starts one entry early, except on
+  // the first row of the matrix which has no lower term
+  if (first == 0) {
+    lower[0] = 0;
+    MPI_File_read_at_all(file, data_offset(2 * ln, 0), lower + 1, local_n - 1,
+                         MPI_INT, MPI_STATUS_IGNORE);
+  } else {
+    MPI_File_read_at_all(file, data_offset(2 * ln, first - 1), lower, local_n,
+                         MPI_INT, MPI_STATUS_IGNORE);
+  }
+
+  int upper_n = first + local_n == n ? local_n - 1 : local_n;
+  MPI_File_read_at_all(file, data_offset(3 * ln - 1, first), upper, upper_n,
+                       MPI_INT, MPI_STATUS_IGNORE);
+
+  MPI_File_close(&file);
+}
+
+// ################################################################################
+// Write
+// ################################################################################
+
+void tridiag_file_write(const char *path, int n, int first, int local_n,
+                        const int *vec, const int *main, const int *lower,
+                        const int *upper, MPI_Comm comm) {
+  MPI_File file = open_file(path, MPI_MODE_WRONLY | MPI_MODE_CREATE, comm);
+  long long ln = n;
+
+  MPI_File_set_size(file, data_offset(4 * ln - 2, 0));
+  write_header(file, "TRID", n, comm);
+
+  MPI_File_write_at_all(file, data_offset(0, first), vec, local_n, MPI_INT,
+                        MPI_STATUS_IGNORE);
+  MPI_File_write_at_all(file, data_offset(ln, first), main, local_n, MPI_INT,
+                        MPI_STATUS_IGNORE);
+
+  // Same shifted slices as the read: entries first - 1 .. first + local_n - 2,
+  // so every entry is written by exactly one rank
+  if (first == 0) {
+    MPI_File_write_at_all(file, data_offset(2 * ln, 0), lower + 1,
+                          local_n - 1, MPI_INT, MPI_STATUS_IGNORE);
+  } else {
+    MPI_File_write_at_all(file, data_offset(2 * ln, first - 1), lower, local_n,
+                          MPI_INT, MPI_STATUS_IGNORE);
+  }
+
+  int upper_n = first + local_n == n ? local_n - 1 : local_n;
+  MPI_File_write_at_all(file, data_offset(3 * ln - 1, first), upper, upper_n,
+                        MPI_INT, MPI_STATUS_IGNORE);
+
+  MPI_File_close(&file);
+}
+
+void vector_file_write(const char *path, int n, int first, int local_n,
+                       const int *y, MPI_Comm comm) {
+  MPI_File file = open_file(path, MPI_MODE_WRONLY | MPI_MODE_CREATE, comm);
+
+  MPI_File_set_size(file, data_offset(n, 0));
+  write_header(file, "VECT", n, comm);
+  MPI_File_write_at_all(file, data_offset(0, first), y, local_n, MPI_INT,
+                        MPI_STATUS_IGNORE);
+
+  MPI_File_close(&file);
+}
@@ -0,0 +1,37 @@
+#ifndef TRIDIAG_IO_H
+#define TRIDIAG_IO_H
+
+#include <mpi.h>
+
+// Binary file of a tridiagonal product y = A x, native byte order: a header
+// {"TRID", version, n} (three ints), then x and the main diagonal (n ints
+// each), lower and upper (n - 1 ints each, lower[i] = A_{i+1,i} like
+// TridiagMatrix). Result files hold {"VECT", version, n} and y.
+//
+// Every rank reads or writes only its own rows [first, first + local_n),
+// with one collective MPI_File_read_at_all / MPI_File_write_at_all per array,
+// so the I/O is spread over the ranks instead of going through rank 0.
+
+#define TRIDIAG_FILE_VERSION 1
+
+// n stored in the file at path, -1 when it cannot be opened. Collective.
+int tridiag_file_size(const char *path, MPI_Comm comm);
+
+// Slices in the layout of matrix_vector_mpi: lower[i] = A_{r,r-1} and
+// upper[i] = A_{r,r+1} for the row r = first + i (row-indexed, the halo
+// offset of the lower diagonal included), lower[0] = 0 on the first row.
+// upper is not read for the last row of the matrix. Collective.
+void tridiag_file_read(const char *path, int n, int first, int local_n,
+                       int *vec, int *main, int *lower, int *upper,
+                       MPI_Comm comm);
+
+// Creates or overwrites path with the slices of all ranks. Collective.
+void tridiag_file_write(const char *path, int n, int first, int local_n,
+                        const int *vec, const int *main, const int *lower,
+                        const int *upper, MPI_Comm comm);
+
+// Writes y, rows [first, first + local_n) from every rank. Collective.
+void vector_file_write(const char *path, int n, int first, int local_n,
+                       const int *y, MPI_Comm comm);
+
+#endif
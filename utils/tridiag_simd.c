@@ -0,0 +1,280 @@
+#include "tridiag_simd.h"
+#include <omp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TRIDIAG_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define TRIDIAG_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Above this many rows the result is written with non-temporal stores: it
+// will not be read back before it is evicted, so skipping the read-for-
+// ownership saves a fifth of the traffic.
+#define TRIDIAG_NT_MIN (1 << 20)
+
+typedef void (*tridiag_rows_fn)(const TridiagMatrix *A, const int *x, int *y,
+                                int lo, int hi);
+
+// Interior row, 0 < i < n - 1
+#define TRIDIAG_ROW(L, M, U, x, i)                                             \
+  ((L)[(i) - 1] * (x)[(i) - 1] + (M)[(i)] * (x)[(i)] + (U)[(i)] * (x)[(i) + 1])
+
+// All the kernels below only see interior rows, boundaries are peeled by
+// tridiag_simd_rows. The scalar head runs until y + i is aligned so the main
+// loop can use aligned (or streaming) stores.
+
+static void rows_scalar(const TridiagMatrix *A, const int *x, int *y, int lo,
+                        int hi) {
+  const int *L = A->lower;
+  const int *M = A->main;
+  const int *U = A->upper;
+  for (int i = lo; i < hi; i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+}
+
+#ifdef TRIDIAG_X86
+
+__attribute__((target("sse4.1"))) static void
+rows_sse(const TridiagMatrix *A, const int *x, int *y, int lo, int hi) {
+  const int *L = A->lower;
+  const int *M = A->main;
+  const int *U = A->upper;
+
+  int i = lo;
+  for (; i < hi && ((uintptr_t)(y + i) & 15); i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+
+  int nt = hi - i >= TRIDIAG_NT_MIN;
+  for (; i + 4 <= hi; i += 4) {
+    __m128i l = _mm_loadu_si128((const __m128i *)(L + i - 1));
+    __m128i m = _mm_loadu_si128((const __m128i *)(M + i));
+    __m128i u = _mm_loadu_si128((const __m128i *)(U + i));
+    __m128i xl = _mm_loadu_si128((const __m128i *)(x + i - 1));
+    __m128i xm = _mm_loadu_si128((const __m128i *)(x + i));
+    __m128i xu = _mm_loadu_si128((const __m128i *)(x + i + 1));
+    __m128i r = _mm_add_epi32(
+        _mm_add_epi32(_mm_mullo_epi32(l, xl), _mm_mullo_epi32(m, xm)),
+        _mm_mullo_epi32(u, xu));
+    if (nt)
+      _mm_stream_si128((__m128i *)(y + i), r);
+    else
+      _mm_store_si128((__m128i *)(y + i), r);
+  }
+  if (nt)
+    _mm_sfence();
+
+  for (; i < hi; i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+}
+
+__attribute__((target("avx2"))) static void
+rows_avx2(const TridiagMatrix *A, const int *x, int *y, int lo, int hi) {
+  const int *L = A->lower;
+  const int *M = A->main;
+  const int *U = A->upper;
+
+  int i = lo;
+  for (; i < hi && ((uintptr_t)(y + i) & 31); i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+
+  int nt = hi - i >= TRIDIAG_NT_MIN;
+  for (; i + 8 <= hi; i += 8) {
+    __m256i l = _mm256_loadu_si256((const __m256i *)(L + i - 1));
+    __m256i m = _mm256_loadu_si256((const __m256i *)(M + i));
+    __m256i u = _mm256_loadu_si256((const __m256i *)(U + i));
+    __m256i xl = _mm256_loadu_si256((const __m256i *)(x + i - 1));
+    __m256i xm = _mm256_loadu_si256((const __m256i *)(x + i));
+    __m256i xu = _mm256_loadu_si256((const __m256i *)(x + i + 1));
+    __m256i r = _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi32(l, xl), _mm256_mullo_epi32(m, xm)),
+        _mm256_mullo_epi32(u, xu));
+    if (nt)
+      _mm256_stream_si256((__m256i *)(y + i), r);
+    else
+      _mm256_store_si256((__m256i *)(y + i), r);
+  }
+  if (nt)
+    _mm_sfence();
+
+  for (; i < hi; i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+}
+
+__attribute__((target("avx512f"))) static void
+rows_avx512(const TridiagMatrix *A, const int *x, int *y, int lo, int hi) {
+  const int *L = A->lower;
+  const int *M = A->main;
+  const int *U = A->upper;
+
+  int i = lo;
+  for (; i < hi && ((uintptr_t)(y + i) & 63); i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+
+  int nt = hi - i >= TRIDIAG_NT_MIN;
+  for (; i + 16 <= hi; i += 16) {
+    __m512i l = _mm512_loadu_si512((const void *)(L + i - 1));
+    __m512i m = _mm512_loadu_si512((const void *)(M + i));
+    __m512i u = _mm512_loadu_si512((const void *)(U + i));
+    __m512i xl = _mm512_loadu_si512((const void *)(x + i - 1));
+    __m512i xm = _mm512_loadu_si512((const void *)(x + i));
+    __m512i xu = _mm512_loadu_si512((const void *)(x + i + 1));
+    __m512i r = _mm512_add_epi32(
+        _mm512_add_epi32(_mm512_mullo_epi32(l, xl), _mm512_mullo_epi32(m, xm)),
+        _mm512_mullo_epi32(u, xu));
+    if (nt)
+      _mm512_stream_si512((void *)(y + i), r);
+    else
+      _mm512_store_si512((void *)(y + i), r);
+  }
+  if (nt)
+    _mm_sfence();
+
+  for (; i < hi; i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+}
+
+#endif
+
+#ifdef TRIDIAG_NEON
+
+static void rows_neon(const TridiagMatrix *A, const int *x, int *y, int lo,
+                      int hi) {
+  const int *L = A->lower;
+  const int *M = A->main;
+  const int *U = A->upper;
+
+  int i = lo;
+  for (; i < hi && ((uintptr_t)(y + i) & 15); i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+
+  for (; i + 4 <= hi; i += 4) {
+    int32x4_t r = vmulq_s32(vld1q_s32(L + i - 1), vld1q_s32(x + i - 1));
+    r = vmlaq_s32(r, vld1q_s32(M + i), vld1q_s32(x + i));
+    r = vmlaq_s32(r, vld1q_s32(U + i), vld1q_s32(x + i + 1));
+    vst1q_s32(y + i, r);
+  }
+
+  for (; i < hi; i++)
+    y[i] = TRIDIAG_ROW(L, M, U, x, i);
+}
+
+#endif
+
+static tridiag_rows_fn tridiag_kernel = NULL;
+static const char *tridiag_kernel_name = NULL;
+
+// Keep the candidate if nothing is forced or if it is the forced one
+static int tridiag_pick(const char *force, const char *name) {
+  return force == NULL || strcmp(force, name) == 0;
+}
+
+void tridiag_simd_init(void) {
+  if (tridiag_kernel != NULL)
+    return;
+
+  const char *force = getenv("TRIDIAG_SIMD");
+  if (force != NULL && force[0] == '\0')
+    force = NULL;
+  tridiag_rows_fn kernel = NULL;
+  const char *name = NULL;
+
+#ifdef TRIDIAG_X86
+  __builtin_cpu_init();
+  if (!kernel && __builtin_cpu_supports("avx512f") &&
+      tridiag_pick(force, "avx512")) {
+    kernel = rows_avx512;
+    name = "avx512";
+  }
+  if (!kernel && __builtin_cpu_supports("avx2") &&
+      tridiag_pick(force, "avx2")) {
+    kernel = rows_avx2;
+    name = "avx2";
+  }
+  if (!kernel && __builtin_cpu_supports("sse4.1") &&
+      tridiag_pick(force, "sse4.1")) {
+    kernel = rows_sse;
+    name = "sse4.1";
+  }
+#endif
+
+#ifdef TRIDIAG_NEON
+  if (!kernel && tridiag_pick(force, "neon")) {
+    kernel = rows_neon;
+    name = "neon";
+  }
+#endif
+
+  if (!kernel) {
+    if (force != NULL && strcmp(force, "scalar") != 0)
+      fprintf(stderr, "Warning: TRIDIAG_SIMD=%s not available, using scalar\n",
+              force);
+    kernel = rows_scalar;
+    name = "scalar";
+  }
+
+  tridiag_kernel_name = name;
+  tridiag_kernel = kernel;
+}
+
+const char *tridiag_simd_kernel(void) {
+  tridiag_simd_init();
+  return tridiag_kernel_name;
+}
+
+void tridiag_simd_rows(const TridiagMatrix *A, const int *x, int *y, int lo,
+                       int hi) {
+  tridiag_simd_init();
+  int n = A->n;
+
+  if (lo == 0) {
+    y[0] = A->main[0] * x[0] + A->upper[0] * x[1];
+    lo = 1;
+  }
+  if (hi == n) {
+    y[n - 1] = A->lower[n - 2] * x[n - 2] + A->main[n - 1] * x[n - 1];
+    hi = n - 1;
+  }
+
+  if (lo < hi)
+    tridiag_kernel(A, x, y, lo, hi);
+}
+
+int *simd_matrix_opti_vector_multiplication(TridiagMatrix *matrix, int *vec,
+                                            int n) {
+  tridiag_simd_init();
+
+  int *result = malloc(n * sizeof(int));
+  tridiag_simd_rows(matrix, vec, result, 0, n);
+
+  return result;
+}
+
+int *omp_simd_matrix_opti_vector_multiplication(TridiagMatrix *matrix,
+                                                int *vec, int n,
+                                                int num_threads) {
+  tridiag_simd_init();
+
+  int *result = malloc(n * sizeof(int));
+
+  omp_set_dynamic(0); // disable automatic thread allocation
+  omp_set_num_threads(num_threads);
+#pragma omp parallel
+  {
+    // Static partition rounded to 16 rows so that every thread starts on its
+    // own cache line and its main loop stays aligned
+    int nb = omp_get_num_threads();
+    int chunk = ((n + nb - 1) / nb + 15) / 16 * 16;
+    int lo = omp_get_thread_num() * chunk;
+    int hi = lo + chunk < n ? lo + chunk : n;
+    if (lo < hi)
+      tridiag_simd_rows(matrix, vec, result, lo, hi);
+  }
+
+  return result;
+}
@@ -0,0 +1,25 @@
+#ifndef TRIDIAG_SIMD_H
+#define TRIDIAG_SIMD_H
+
+#include "utils.h"
+
+// Explicit SIMD kernels for y = A x with A tridiagonal.
+// The kernel (avx512, avx2, sse4.1, neon or scalar) is picked once from cpuid;
+// the TRIDIAG_SIMD environment variable forces one of them by name.
+
+void tridiag_simd_init(void);
+
+const char *tridiag_simd_kernel(void);
+
+// y[i] = (A x)_i for lo <= i < hi, boundary rows 0 and n-1 included
+void tridiag_simd_rows(const TridiagMatrix *A, const int *x, int *y, int lo,
+                       int hi);
+
+int *simd_matrix_opti_vector_multiplication(TridiagMatrix *matrix, int *vec,
+                                            int n);
+
+int *omp_simd_matrix_opti_vector_multiplication(TridiagMatrix *matrix,
+                                                int *vec, int n,
+                                                int num_threads);
+
+#endif
@@ -1,9 +1,87 @@
+#define _GNU_SOURCE
+
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Number of random_vec / random_vec_first_touch calls so far: the k-th
+// generated vector uses stream RNG_STREAM_VEC + k
+static int vec_streams = 0;
+
+static int default_threads(void) {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+uint64_t get_seed(void) {
+  const char *env = getenv("HPC_SEED");
+  if (env != NULL && env[0] != '\0')
+    return strtoull(env, NULL, 0);
+  return HPC_DEFAULT_SEED;
+}
+
+void init_random(void) { srand((unsigned)get_seed()); }
+
+// SplitMix64 finalizer
+static uint64_t mix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t rng_stream(uint64_t seed, int stream) {
+  return mix64(seed + 0x9E3779B97F4A7C15ULL * (uint64_t)(stream + 1));
+}
+
+int rng_range(uint64_t stream, long long index, int lo, int hi) {
+  uint64_t h = mix64(stream + 0x9E3779B97F4A7C15ULL * (uint64_t)(index + 1));
+  // Scale the high 32 bits to [0, hi - lo] without the modulo bias
+  return (int)(((h >> 32) * (uint64_t)(hi - lo + 1)) >> 32) + lo;
+}
+
+int rng_value(uint64_t stream, long long index) {
+  return rng_range(stream, index, -10, 10);
+}
+
+void fill_random_vec(int *vec, int count, long long offset, uint64_t stream,
+                     int num_threads) {
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+  for (int i = 0; i < count; i++) {
+    vec[i] = rng_value(stream, offset + i);
+  }
+}
+
+// Allocates a vector and fills it in parallel, which is also its first touch
+static int *random_vec_stream(int n, int stream, int num_threads) {
+  if (n <= 0) {
+    fprintf(stderr, "Error: n must be greater than 0\n");
+    exit(1);
+  }
+
+  int *vec = malloc(n * sizeof(int));
+  if (vec == NULL) {
+    fprintf(stderr, "Error: Could not allocate vector of size %d\n", n);
+    exit(1);
+  }
+
+  fill_random_vec(vec, n, 0, rng_stream(get_seed(), stream), num_threads);
 
-void init_random(void) { srand(time(NULL)); }
+  return vec;
+}
 
 void print_vec(int *vec, int n) {
   for (int i = 0; i < n; i++) {
@@ -22,19 +100,8 @@ void print_matrix(int **matrix, int n) {
 }
 
 int *random_vec(int n) {
-  if (n > 0) {
-    int *vec = malloc(n * sizeof(int));
-
-    for (int i = 0; i < n; i++) {
-      int r = (rand() % 21) - 10; // Random number between -10 and 10
-      vec[i] = r;
-    }
-
-    return vec;
-  } else {
-    fprintf(stderr, "Error: n must be greater than 0\n");
-    exit(1);
-  }
+  return random_vec_stream(n, RNG_STREAM_VEC + vec_streams++,
+                           default_threads());
 }
 
 int **random_tridiagonal_matrix(int n) {
@@ -51,13 +118,18 @@ int **random_tridiagonal_matrix(int n) {
     }
   }
 
-  // Fill only the non-zero diagonals
+  // Fill only the non-zero diagonals, with the same streams as
+  // random_opti_tridiagonal_matrix so both storages hold the same matrix
+  uint64_t seed = get_seed();
+  uint64_t lower = rng_stream(seed, RNG_STREAM_LOWER);
+  uint64_t main = rng_stream(seed, RNG_STREAM_MAIN);
+  uint64_t upper = rng_stream(seed, RNG_STREAM_UPPER);
   for (int i = 0; i < n; i++) {
     if (i > 0)
-      matrix[i][i - 1] = (rand() % 21) - 10;
-    matrix[i][i] = (rand() % 21) - 10;
+      matrix[i][i - 1] = rng_value(lower, i - 1);
+    matrix[i][i] = rng_value(main, i);
     if (i < n - 1)
-      matrix[i][i + 1] = (rand() % 21) - 10;
+      matrix[i][i + 1] = rng_value(upper, i);
   }
 
   return matrix;
@@ -78,14 +150,145 @@ TridiagMatrix *random_opti_tridiagonal_matrix(int n) {
   TridiagMatrix *matrix = malloc(sizeof(TridiagMatrix));
 
   matrix->n = n;
-  matrix->lower = random_vec(n - 1);
-  matrix->main = random_vec(n);
-  matrix->upper = random_vec(n - 1);
+  matrix->lower = random_vec_stream(n - 1, RNG_STREAM_LOWER, default_threads());
+  matrix->main = random_vec_stream(n, RNG_STREAM_MAIN, default_threads());
+  matrix->upper = random_vec_stream(n - 1, RNG_STREAM_UPPER, default_threads());
+
+  return matrix;
+}
+
+void fill_spd_tridiagonal_rows(int n, int first, int count, int *lower,
+                               int *main, int *upper) {
+  uint64_t off = rng_stream(get_seed(), RNG_STREAM_UPPER);
+  uint64_t diag = rng_stream(get_seed(), RNG_STREAM_MAIN);
+
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < count; i++) {
+    int r = first + i;
+    int l = r > 0 ? rng_value(off, r - 1) : 0;
+    int u = r < n - 1 ? rng_value(off, r) : 0;
+    lower[i] = l;
+    upper[i] = u;
+    main[i] = abs(l) + abs(u) + rng_range(diag, r, 1, 10);
+  }
+}
+
+TridiagMatrix *random_spd_tridiagonal_matrix(int n) {
+
+  if (n <= 1) {
+    fprintf(stderr, "Error : n must be greater than 1\n");
+    exit(1);
+  }
+
+  TridiagMatrix *matrix = malloc(sizeof(TridiagMatrix));
+  int *lower = malloc(n * sizeof(int));
+  int *upper = malloc(n * sizeof(int));
+
+  matrix->n = n;
+  matrix->main = malloc(n * sizeof(int));
+  fill_spd_tridiagonal_rows(n, 0, n, lower, matrix->main, upper);
+
+  // Row-indexed to the usual storage: lower[i] is A_{i+1,i}
+  memmove(lower, lower + 1, (n - 1) * sizeof(int));
+  matrix->lower = lower;
+  matrix->upper = upper;
+
+  return matrix;
+}
+
+int *alloc_vec_first_touch(int n, int num_threads) {
+  if (n <= 0) {
+    fprintf(stderr, "Error: n must be greater than 0\n");
+    exit(1);
+  }
+
+  int *vec = malloc(n * sizeof(int));
+  if (vec == NULL) {
+    fprintf(stderr, "Error: Could not allocate vector of size %d\n", n);
+    exit(1);
+  }
+
+  // Pages are placed on the node of the thread that first writes them, so
+  // touch them with the same static partition the compute loops use
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+  for (int i = 0; i < n; i++) {
+    vec[i] = 0;
+  }
+
+  return vec;
+}
+
+int *random_vec_first_touch(int n, int num_threads) {
+  // The parallel fill already touches every page with the static partition
+  return random_vec_stream(n, RNG_STREAM_VEC + vec_streams++, num_threads);
+}
+
+TridiagMatrix *random_opti_tridiagonal_matrix_first_touch(int n,
+                                                          int num_threads) {
+
+  if (n <= 1) {
+    fprintf(stderr, "Error : n must be greater than 1\n");
+    exit(1);
+  }
+
+  TridiagMatrix *matrix = malloc(sizeof(TridiagMatrix));
+
+  matrix->n = n;
+  matrix->lower = random_vec_stream(n - 1, RNG_STREAM_LOWER, num_threads);
+  matrix->main = random_vec_stream(n, RNG_STREAM_MAIN, num_threads);
+  matrix->upper = random_vec_stream(n - 1, RNG_STREAM_UPPER, num_threads);
 
   return matrix;
 }
 
-void log_execution_time(const char *filename, const char *method, int size, int nb_process, double time) {
+void report_numa_placement(const char *name, const void *ptr, size_t bytes) {
+  if (getenv("NUMA_REPORT") == NULL || bytes == 0)
+    return;
+
+#if defined(__linux__) && defined(SYS_move_pages)
+  enum { MAX_SAMPLES = 4096, MAX_NODES = 64 };
+  long page = sysconf(_SC_PAGESIZE);
+  char *start = (char *)((unsigned long)ptr & ~(unsigned long)(page - 1));
+  size_t npages = ((char *)ptr + bytes - start + page - 1) / page;
+  size_t step = npages > MAX_SAMPLES ? npages / MAX_SAMPLES : 1;
+  size_t count = (npages + step - 1) / step;
+
+  void **pages = malloc(count * sizeof(void *));
+  int *status = malloc(count * sizeof(int));
+  for (size_t p = 0; p < count; p++)
+    pages[p] = start + p * step * page;
+
+  // With nodes == NULL, move_pages only reports where each page lives
+  if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0) != 0) {
+    fprintf(stderr, "%s: move_pages failed, placement unknown\n", name);
+  } else {
+    size_t per_node[MAX_NODES] = {0};
+    size_t unplaced = 0;
+    for (size_t p = 0; p < count; p++) {
+      if (status[p] >= 0 && status[p] < MAX_NODES)
+        per_node[status[p]]++;
+      else
+        unplaced++;
+    }
+
+    printf("%s:", name);
+    for (int node = 0; node < MAX_NODES; node++) {
+      if (per_node[node] > 0)
+        printf(" node%d %.1f%%", node, 100.0 * per_node[node] / count);
+    }
+    if (unplaced > 0)
+      printf(" not placed %.1f%%", 100.0 * unplaced / count);
+    printf(" (%zu pages sampled)\n", count);
+  }
+
+  free(pages);
+  free(status);
+#else
+  fprintf(stderr, "%s: NUMA placement report needs Linux move_pages\n", name);
+#endif
+}
+
+void log_execution_time(const char *filename, const char *method, long long size, int nb_process, double time) {
   FILE *file = fopen(filename, "r");
   int write_header = 0;
   if (file == NULL) {
@@ -109,6 +312,9 @@ void log_execution_time(const char *filename, const char *method, int size, int
     fprintf(file, "method,size,nb_proc,time\n");
   }
 
-  fprintf(file, "%s,%d,%d,%lf\n", method, size, nb_process, time);
+  fprintf(file, "%s,%lld,%d,%lf\n", method, size, nb_process, time);
   fclose(file);
+
+  // Counters of the region just timed, if perf_start/perf_stop wrapped it
+  perf_log(filename, method, size, nb_process);
 }
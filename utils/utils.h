@@ -1,6 +1,23 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "perf.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Input data comes from a counter-based generator: entry i of a stream is a
+// pure function of (seed, stream, i), so any thread or MPI rank can produce
+// any slice and the data does not depend on how the work is split.
+// The seed is read from HPC_SEED, HPC_DEFAULT_SEED otherwise.
+#define HPC_DEFAULT_SEED 20240101ULL
+
+// Streams of the diagonals of random_opti_tridiagonal_matrix, the k-th
+// random_vec of a program uses RNG_STREAM_VEC + k
+#define RNG_STREAM_LOWER 1
+#define RNG_STREAM_MAIN 2
+#define RNG_STREAM_UPPER 3
+#define RNG_STREAM_VEC 16
+
 typedef struct {
   int n;
   int *lower; // sub diagonal
@@ -28,8 +45,22 @@ typedef struct {
   int *upper3; // super-super-super diagonal (i+3)
 } HeptaDiagMatrix;
 
+uint64_t get_seed(void);
+
 void init_random(void);
 
+uint64_t rng_stream(uint64_t seed, int stream);
+
+// Value in [lo, hi] of entry index of a stream
+int rng_range(uint64_t stream, long long index, int lo, int hi);
+
+// Value in [-10, 10] of entry index of a stream
+int rng_value(uint64_t stream, long long index);
+
+// vec[i] = entry offset + i of the stream, for 0 <= i < count
+void fill_random_vec(int *vec, int count, long long offset, uint64_t stream,
+                     int num_threads);
+
 void print_vec(int *vec, int n);
 
 void print_matrix(int **matrix, int n);
@@ -40,7 +71,32 @@ int **random_tridiagonal_matrix(int n);
 
 TridiagMatrix *random_opti_tridiagonal_matrix(int n);
 
-void log_execution_time(const char *filename, const char *method, int size,
-                        int nb_process, double time);
+// Symmetric, strictly diagonally dominant matrix with a positive diagonal
+// (so positive definite), for the solvers: A_{i,i+1} = A_{i+1,i} is the
+// upper stream value, A_{i,i} = |A_{i,i-1}| + |A_{i,i+1}| + [1, 10] from the
+// main stream.
+TridiagMatrix *random_spd_tridiagonal_matrix(int n);
+
+// Rows first .. first + count - 1 of the same matrix, row-indexed like the
+// MPI slices: lower[i] = A_{r,r-1}, upper[i] = A_{r,r+1} for r = first + i,
+// 0 outside the matrix
+void fill_spd_tridiagonal_rows(int n, int first, int count, int *lower,
+                               int *main, int *upper);
+
+// NUMA-aware variants: pages are first touched in parallel with the static
+// partition of num_threads threads (the random ones fill while touching)
+int *alloc_vec_first_touch(int n, int num_threads);
+
+int *random_vec_first_touch(int n, int num_threads);
+
+TridiagMatrix *random_opti_tridiagonal_matrix_first_touch(int n,
+                                                          int num_threads);
+
+// Prints the share of the pages of [ptr, ptr + bytes) on each NUMA node.
+// Does nothing unless the NUMA_REPORT environment variable is set.
+void report_numa_placement(const char *name, const void *ptr, size_t bytes);
+
+void log_execution_time(const char *filename, const char *method,
+                        long long size, int nb_process, double time);
 
 #endif
\ No newline at end of file